@@ -0,0 +1,135 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file janeth-velodyne-bench.cpp
+    \brief This file benchmarks the parsing of Velodyne packets from a BAG
+           file generated by JanETH.
+  */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <QtCore/QElapsedTimer>
+
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/StdVector>
+
+#include <libvelodyne/sensor/Calibration.h>
+#include <libvelodyne/sensor/DataPacket.h>
+#include <libvelodyne/sensor/Converter.h>
+
+#include <libsnappy/snappy.h>
+
+#include <velodyne/BinarySnappyMsg.h>
+
+#include "gui/VelodyneConverter.h"
+#include "gui/VelodyneDecoder.h"
+
+#include "utils/PointCloud.h"
+
+/// Parses a packet through a string and a string stream, as done before
+bool parseStream(const velodyne::BinarySnappyMsg& msg,
+    DataPacket& dataPacket) {
+  std::string uncompressedData;
+  if (!snappy::Uncompress(reinterpret_cast<const char*>(msg.data.data()),
+      msg.data.size(), &uncompressedData))
+    return false;
+  std::istringstream binaryStream(uncompressedData);
+  dataPacket.readBinary(binaryStream);
+  return true;
+}
+
+/// Runs a benchmark for at least one second and reports packets per second
+void benchmark(const std::string& name, size_t numPackets,
+    const std::function<void(size_t)>& parse) {
+  QElapsedTimer timer;
+  size_t numParsed = 0;
+  timer.start();
+  do {
+    for (size_t i = 0; i < numPackets; ++i)
+      parse(i);
+    numParsed += numPackets;
+  } while (timer.elapsed() < 1000);
+  const double seconds = timer.nsecsElapsed() * 1e-9;
+  std::cout << name << ": " << numParsed / seconds << " packets/s"
+    << std::endl;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " BAG [CALIBRATION]" << std::endl;
+    return 1;
+  }
+
+  std::vector<velodyne::BinarySnappyMsgConstPtr> messages;
+  try {
+    rosbag::Bag bag(argv[1]);
+    rosbag::View view(bag, rosbag::TypeQuery(
+      ros::message_traits::datatype<velodyne::BinarySnappyMsg>()));
+    for (auto it = view.begin(); it != view.end(); ++it)
+      messages.push_back(it->instantiate<velodyne::BinarySnappyMsg>());
+  }
+  catch (std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+  if (messages.empty()) {
+    std::cerr << "Error: no Velodyne packets in " << argv[1] << std::endl;
+    return 1;
+  }
+  std::cout << messages.size() << " packets" << std::endl;
+
+  DataPacket dataPacket;
+  VelodyneDecoder::Buffer buffer;
+  try {
+    benchmark("string stream", messages.size(), [&](size_t i) {
+      parseStream(*messages[i], dataPacket);
+    });
+    benchmark("reused buffer", messages.size(), [&](size_t i) {
+      VelodyneDecoder::parse(*messages[i], buffer, dataPacket);
+    });
+
+    if (argc > 2) {
+      std::ifstream calibFile(argv[2]);
+      Calibration calibration;
+      calibFile >> calibration;
+      VelodyneConverter converter(calibration);
+      PointCloud<float> pointCloud(PointCloud<float>::Intensities);
+      benchmark("reused buffer + conversion", messages.size(),
+          [&](size_t i) {
+        pointCloud.clear();
+        if (VelodyneDecoder::parse(*messages[i], buffer, dataPacket))
+          converter.toPointCloud(dataPacket, pointCloud,
+            Converter::mMinDistance, Converter::mMaxDistance);
+      });
+    }
+  }
+  catch (std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -25,6 +25,7 @@
 #include <rosbag/exceptions.h>
 
 #include "gui/framework.h"
+#include "gui/MessageDispatcher.h"
 
 #include "ui_BagControl.h"
 
@@ -34,18 +35,34 @@
 
 BagControl::BagControl() :
     _ui(new Ui_BagControl()),
-    _msgCnt(0) {
+    _seeking(false),
+    _msgCnt(0),
+    _hasNextMessage(false),
+    _speed(1.0) {
   _ui->setupUi(this);
   _timer.setSingleShot(true);
   connect(&_timer, SIGNAL(timeout()), this, SLOT(timerTimeout()));
+  _queryTimer.setSingleShot(true);
+  connect(&_queryTimer, SIGNAL(timeout()), this, SLOT(queryTimerTimeout()));
+  _seekTimer.setSingleShot(true);
+  connect(&_seekTimer, SIGNAL(timeout()), this, SLOT(seekTimerTimeout()));
+  _replayTimer.setSingleShot(true);
+  connect(&_replayTimer, SIGNAL(timeout()), this,
+    SLOT(replayTimerTimeout()));
+  connect(&MessageDispatcher::getInstance(), SIGNAL(receiversChanged()),
+    this, SLOT(receiversChanged()));
   _ui->startTimeEdit->setReadOnly(true);
   _ui->endTimeEdit->setReadOnly(true);
+  _ui->lagEdit->setReadOnly(true);
+  setSpeed(_speed);
   if (Framework::getInstance().hasArgument() &&
       (Framework::getInstance()[0].endsWith("bag")))
     setLogFilename(Framework::getInstance()[0]);
 }
 
 BagControl::~BagControl() {
+  _reader.stop();
+  _index.stop();
   delete _ui;
 }
 
@@ -57,23 +74,32 @@ void BagControl::setLogFilename(const QString& filename) {
   _ui->logEdit->setText(filename);
   QFileInfo fileInfo(filename);
   if (fileInfo.isFile() && fileInfo.isReadable()) {
+    _reader.stop();
+    _index.stop();
+    _view.reset();
+    size_t numMessages = 0;
     try {
       _bag.reset(new rosbag::Bag(filename.toStdString()));
-      _view.reset(new rosbag::View(*_bag));
-      _bagBeginIt.reset(new rosbag::View::iterator(_view->begin()));
-      _bagEndIt.reset(new rosbag::View::iterator(_view->end()));
+      rosbag::View view(*_bag);
+      numMessages = view.size();
+      _startTime = view.getBeginTime();
+      _endTime = view.getEndTime();
     }
     catch (rosbag::BagException& e) {
+      _bag.reset();
       QMessageBox::information(this, "BagControl",
         tr("Exception: %1.").arg(e.what()));
+      return;
     }
+    _index.load(filename.toStdString());
+    _ui->logSlider->setEnabled(true);
     _ui->logPlayButton->setEnabled(true);
     _ui->logStopButton->setEnabled(true);
     _ui->logForwardButton->setEnabled(true);
     _ui->msgSpinBox->setEnabled(true);
-    _ui->msgSpinBox->setValue(_view->size());
+    _ui->msgSpinBox->setValue(numMessages);
     _ui->startTimeEdit->setEnabled(true);
-    const double startTimestamp = _view->getBeginTime().toSec();
+    const double startTimestamp = _startTime.toSec();
     const QDateTime startTime = QDateTime::fromTime_t(startTimestamp);
     QString startMsecs;
     startMsecs.sprintf("%03d", (uint)((startTimestamp -
@@ -81,7 +107,7 @@ void BagControl::setLogFilename(const QString& filename) {
     _ui->startTimeEdit->setText(startTime.toString(
       "yyyy-MM-dd hh:mm:ss:" + startMsecs));
     _ui->endTimeEdit->setEnabled(true);
-    const double endTimestamp = _view->getEndTime().toSec();
+    const double endTimestamp = _endTime.toSec();
     const QDateTime endTime = QDateTime::fromTime_t(endTimestamp);
     QString endMsecs;
     endMsecs.sprintf("%03d", (uint)((endTimestamp -
@@ -92,10 +118,112 @@ void BagControl::setLogFilename(const QString& filename) {
   }
 }
 
+void BagControl::setSpeed(double speed) {
+  _ui->speedComboBox->blockSignals(true);
+  if (speed > 0)
+    _ui->speedComboBox->setCurrentIndex(
+      _ui->speedComboBox->findText(QString("%1x").arg(speed)));
+  else
+    _ui->speedComboBox->setCurrentIndex(
+      _ui->speedComboBox->findText("Max"));
+  _ui->speedComboBox->blockSignals(false);
+  const ros::Time time = getClockTime();
+  _speed = speed;
+  setClockTime(time);
+}
+
+ros::Time BagControl::getClockTime() const {
+  if (_speed > 0 && _clock.isValid())
+    return _clockStartTime + ros::Duration(_clock.elapsed() * 1e-3 * _speed);
+  else
+    return _currTime;
+}
+
+void BagControl::setClockTime(const ros::Time& time) {
+  _clockStartTime = time;
+  _clock.start();
+}
+
 /******************************************************************************/
 /* Methods                                                                    */
 /******************************************************************************/
 
+bool BagControl::isConsumed(const rosbag::ConnectionInfo* connectionInfo) {
+  return MessageDispatcher::getInstance().isConsumed(connectionInfo->topic,
+    connectionInfo->md5sum);
+}
+
+void BagControl::setView(const ros::Time& startTime) {
+  _reader.stop();
+  _view.reset(new rosbag::View(*_bag, &BagControl::isConsumed, startTime,
+    _endTime));
+  _reader.start(_view->begin(), _view->end());
+  _nextMessage = BagMessage();
+  _hasNextMessage = false;
+  _skipCounts.clear();
+}
+
+void BagControl::seek(const ros::Time& time) {
+  MessageDispatcher::getInstance().seek();
+  _currTime = _index.getRestoreTime(time);
+  _msgCnt = 0;
+  _stampCounts.clear();
+  setView(_currTime);
+  _seekTime = time;
+  _seeking = true;
+  _replayTimer.start(0);
+}
+
+bool BagControl::popNextMessage() {
+  while (!_hasNextMessage && _reader.pop(_nextMessage)) {
+    std::map<std::string, size_t>::iterator it =
+      _skipCounts.find(_nextMessage.topic);
+    if ((_nextMessage.time == _currTime) && (it != _skipCounts.end()) &&
+        it->second) {
+      --it->second;
+      _nextMessage = BagMessage();
+    }
+    else
+      _hasNextMessage = true;
+  }
+  return _hasNextMessage;
+}
+
+void BagControl::consumeNextMessage() {
+  if (_nextMessage.time != _currTime)
+    _stampCounts.clear();
+  ++_stampCounts[_nextMessage.topic];
+  _currTime = _nextMessage.time;
+  _nextMessage = BagMessage();
+  _hasNextMessage = false;
+  _msgCnt++;
+}
+
+void BagControl::updateCurrentTime() {
+  _ui->currTimeEdit->setEnabled(true);
+  const double timestamp = _currTime.toSec();
+  const QDateTime time = QDateTime::fromTime_t(timestamp);
+  QString msecs;
+  msecs.sprintf("%03d", (uint)((timestamp - (size_t)timestamp) * 1e3));
+  _ui->currTimeEdit->setText(time.toString(
+    "yyyy-MM-dd hh:mm:ss:" + msecs));
+  if ((_endTime > _startTime) && !_ui->logSlider->isSliderDown())
+    _ui->logSlider->setSliderPosition(_ui->logSlider->minimum() +
+      (_ui->logSlider->maximum() - _ui->logSlider->minimum()) *
+      (_currTime - _startTime).toSec() / (_endTime - _startTime).toSec());
+}
+
+void BagControl::updateLag(double lag, const QString& stage) {
+  if (lag > 0) {
+    _ui->lagEdit->setEnabled(true);
+    _ui->lagEdit->setText(tr("%1 s (%2)").arg(lag, 0, 'f', 2).arg(stage));
+  }
+  else {
+    _ui->lagEdit->setEnabled(false);
+    _ui->lagEdit->setText("");
+  }
+}
+
 void BagControl::logBrowseClicked() {
   QString filename = QFileDialog::getOpenFileName(this, "Open Log File",
     _ui->logEdit->text(), "ROS bag files (*.bag)");
@@ -108,42 +236,143 @@ void BagControl::logPlayToggled() {
   _ui->logForwardButton->setEnabled(!_ui->logPlayButton->isChecked());
   _ui->logBrowseButton->setEnabled(!_ui->logPlayButton->isChecked());
   if (_ui->logPlayButton->isChecked()) {
+    setClockTime(_currTime);
+    _tickClock.start();
     _timer.start(0);
   }
-  else
+  else {
     _timer.stop();
+    updateLag(0, "");
+  }
 }
 
 void BagControl::logStopClicked() {
-  _bagCurrIt.reset(new rosbag::View::iterator(*_bagBeginIt));
+  _replayTimer.stop();
+  _seeking = false;
+  setView(_startTime);
+  _currTime = _startTime;
+  setClockTime(_currTime);
   _msgCnt = 0;
+  _stampCounts.clear();
   _ui->logSlider->setSliderPosition(_ui->logSlider->minimum());
 }
 
 void BagControl::logForwardClicked() {
-  if ((*_bagCurrIt) != (*_bagEndIt)) {
-    (*_bagCurrIt)++;
-    _msgCnt++;
+  if (_seeking)
+    return;
+  if (popNextMessage()) {
+    consumeNextMessage();
+    updateCurrentTime();
   }
 }
 
+void BagControl::logSliderActionTriggered(int action) {
+  if (_bag)
+    _seekTimer.start(0);
+}
+
+void BagControl::seekTimerTimeout() {
+  if (_bag && (_ui->logSlider->maximum() > _ui->logSlider->minimum()))
+    seek(_startTime + ros::Duration((_endTime - _startTime).toSec() *
+      (_ui->logSlider->sliderPosition() - _ui->logSlider->minimum()) /
+      (_ui->logSlider->maximum() - _ui->logSlider->minimum())));
+}
+
+void BagControl::replayTimerTimeout() {
+  QElapsedTimer processingClock;
+  processingClock.start();
+  const double processingBudget = 0.02;
+  bool done = false;
+  while (!done) {
+    if (!popNextMessage()) {
+      if (!_reader.isDone()) {
+        _replayTimer.start(1);
+        return;
+      }
+      done = true;
+    }
+    else if (_nextMessage.time >= _seekTime)
+      done = true;
+    else if (processingClock.elapsed() * 1e-3 > processingBudget) {
+      _replayTimer.start(0);
+      return;
+    }
+    else {
+      MessageDispatcher::getInstance().dispatch(_nextMessage.message,
+        _nextMessage.topic);
+      consumeNextMessage();
+    }
+  }
+  _seeking = false;
+  _currTime = _seekTime;
+  setClockTime(_currTime);
+  _msgCnt = 0;
+  _stampCounts.clear();
+  updateCurrentTime();
+}
+
+void BagControl::speedChanged(const QString& speed) {
+  if (speed == "Max")
+    setSpeed(0);
+  else
+    setSpeed(speed.left(speed.length() - 1).toDouble());
+}
+
 void BagControl::timerTimeout() {
-  if ((*_bagCurrIt) != (*_bagEndIt)) {
-    _ui->currTimeEdit->setEnabled(true);
-    const double timestamp = (*_bagCurrIt)->getTime().toSec();
-    const QDateTime time = QDateTime::fromTime_t(timestamp);
-    QString msecs;
-    msecs.sprintf("%03d", (uint)((timestamp - (size_t)timestamp) * 1e3));
-    _ui->currTimeEdit->setText(time.toString(
-      "yyyy-MM-dd hh:mm:ss:" + msecs));
-    emit messageRead(*(*_bagCurrIt));
-    (*_bagCurrIt)++;
-    _msgCnt++;
-    _ui->logSlider->setSliderPosition(_ui->logSlider->minimum() +
-      (_ui->logSlider->maximum() - _ui->logSlider->minimum()) *
-      (double)_msgCnt / (double)_view->size());
-    _timer.start(0);
+  if (_seeking) {
+    _timer.start(10);
+    return;
+  }
+  const double renderingTime = _tickClock.restart() * 1e-3;
+  QElapsedTimer processingClock;
+  processingClock.start();
+  const ros::Time clockTime = getClockTime();
+  const double processingBudget = 0.02;
+  bool starved = false;
+  bool overBudget = false;
+  while (true) {
+    if (!popNextMessage()) {
+      starved = !_reader.isDone();
+      break;
+    }
+    if (_speed > 0 && _nextMessage.time > clockTime)
+      break;
+    if (processingClock.elapsed() * 1e-3 > processingBudget) {
+      overBudget = true;
+      break;
+    }
+    MessageDispatcher::getInstance().dispatch(_nextMessage.message,
+      _nextMessage.topic);
+    consumeNextMessage();
+  }
+  updateCurrentTime();
+  if (_speed > 0 && (starved || overBudget)) {
+    const double processingTime = processingClock.elapsed() * 1e-3;
+    updateLag((clockTime - _currTime).toSec(), starved ? tr("reading") :
+      renderingTime > processingTime ? tr("rendering") : tr("processing"));
   }
   else
+    updateLag(0, "");
+  _tickClock.restart();
+  if (_hasNextMessage || !_reader.isDone())
+    _timer.start(_speed > 0 && !overBudget ? 10 : 0);
+  else {
     _timer.stop();
+    if (!_reader.getError().empty())
+      QMessageBox::information(this, "BagControl",
+        tr("Exception: %1.").arg(_reader.getError().c_str()));
+  }
+}
+
+void BagControl::receiversChanged() {
+  _queryTimer.start(0);
+}
+
+void BagControl::queryTimerTimeout() {
+  if (_bag) {
+    // The view restarts at the current time, the messages already played at
+    // that time are skipped
+    setView(_currTime);
+    _skipCounts = _stampCounts;
+  }
 }
@@ -23,15 +23,19 @@
 #ifndef BAGCONTROL_H
 #define BAGCONTROL_H
 
+#include <map>
+#include <string>
 #include <memory>
 
 #include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
 
 #include <rosbag/bag.h>
 #include <rosbag/view.h>
-#include <rosbag/message_instance.h>
 
 #include "gui/control.h"
+#include "gui/BagReader.h"
+#include "gui/BagIndex.h"
 
 class Ui_BagControl;
 
@@ -67,10 +71,36 @@ public:
     */
   /// Sets the log file name to play
   void setLogFilename(const QString& filename);
+  /// Sets the playback speed relative to real time, 0 for maximum speed
+  void setSpeed(double speed);
   /** @}
     */
 
 protected:
+  /** \name Protected methods
+    @{
+    */
+  /// Rebuilds the view over the consumed topics from a given time
+  void setView(const ros::Time& startTime);
+  /// Seeks to a given time, restoring the state of the controls
+  void seek(const ros::Time& time);
+  /// Fetches the next message, skipping those played before a rebuild
+  bool popNextMessage();
+  /// Marks the next message as played
+  void consumeNextMessage();
+  /// Returns true if a connection of the bag is consumed
+  static bool isConsumed(const rosbag::ConnectionInfo* connectionInfo);
+  /// Returns the bag time the playback clock is at
+  ros::Time getClockTime() const;
+  /// Restarts the playback clock at a given bag time
+  void setClockTime(const ros::Time& time);
+  /// Displays the current time
+  void updateCurrentTime();
+  /// Displays the lag behind the playback clock and its cause
+  void updateLag(double lag, const QString& stage);
+  /** @}
+    */
+
   /** \name Protected members
     @{
     */
@@ -78,18 +108,48 @@ protected:
   Ui_BagControl* _ui;
   /// Timer controlling the reading of the bag file
   QTimer _timer;
+  /// Timer coalescing the updates of the topic query
+  QTimer _queryTimer;
+  /// Timer coalescing the seeks of the slider
+  QTimer _seekTimer;
+  /// Timer replaying the messages up to the seek time
+  QTimer _replayTimer;
+  /// Time the replay is seeking to
+  ros::Time _seekTime;
+  /// Replay up to the seek time in progress
+  bool _seeking;
   /// ROS bag reader
   std::shared_ptr<rosbag::Bag> _bag;
-  /// ROS bag view
+  /// ROS bag view restricted to the consumed topics
   std::shared_ptr<rosbag::View> _view;
-  /// Begin iterator of the bag file
-  std::shared_ptr<rosbag::View::iterator> _bagBeginIt;
-  /// End iterator of the bag file
-  std::shared_ptr<rosbag::View::iterator> _bagEndIt;
-  /// Current iterator of the bag file
-  std::shared_ptr<rosbag::View::iterator> _bagCurrIt;
-  /// Message count
+  /// Background reader of the bag file
+  BagReader _reader;
+  /// Seek index of the bag file
+  BagIndex _index;
+  /// Start time of the bag file
+  ros::Time _startTime;
+  /// End time of the bag file
+  ros::Time _endTime;
+  /// Time of the last message played
+  ros::Time _currTime;
+  /// Message count since the last stop
   size_t _msgCnt;
+  /// Messages played per topic at the time of the last message played
+  std::map<std::string, size_t> _stampCounts;
+  /// Messages per topic to skip at the current time after a rebuild
+  std::map<std::string, size_t> _skipCounts;
+  /// Next message to be played
+  BagMessage _nextMessage;
+  /// Next message available
+  bool _hasNextMessage;
+  /// Playback speed, 0 for maximum speed
+  double _speed;
+  /// Wall clock elapsed since the playback clock was started
+  QElapsedTimer _clock;
+  /// Bag time at which the playback clock was started
+  ros::Time _clockStartTime;
+  /// Wall clock elapsed since the last timer timeout
+  QElapsedTimer _tickClock;
   /** @}
     */
 
@@ -105,17 +165,20 @@ protected slots:
   void logStopClicked();
   /// Log forward clicked
   void logForwardClicked();
+  /// Log slider moved by the user
+  void logSliderActionTriggered(int action);
+  /// Timeout of the seek timer
+  void seekTimerTimeout();
+  /// Timeout of the replay timer
+  void replayTimerTimeout();
+  /// Speed changed
+  void speedChanged(const QString& speed);
   /// Timeout of the timer
   void timerTimeout();
-  /** @}
-    */
-
-signals:
-  /** \name Qt signals
-    @{
-    */
-  /// New message read from the bag file
-  void messageRead(const rosbag::MessageInstance& message);
+  /// Receivers of the messages changed
+  void receiversChanged();
+  /// Timeout of the query timer
+  void queryTimerTimeout();
   /** @}
     */
 
@@ -0,0 +1,215 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include "gui/BagIndex.h"
+
+#include <algorithm>
+#include <exception>
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QDateTime>
+#include <QtCore/QDataStream>
+
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <rosbag/query.h>
+
+#include <velodyne/BinarySnappyMsg.h>
+#include <poslv/VehicleNavigationSolutionMsg.h>
+
+#include <libvelodyne/sensor/DataPacket.h>
+
+#include "gui/VelodyneDecoder.h"
+
+/******************************************************************************/
+/* Statics                                                                    */
+/******************************************************************************/
+
+const double BagIndex::_poseKeySpacing = 0.1;
+const unsigned int BagIndex::_version = 1;
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+BagIndex::BagIndex() :
+    _stopRequested(false),
+    _ready(false) {
+}
+
+BagIndex::~BagIndex() {
+  stop();
+}
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+std::string BagIndex::getIndexFilename(const std::string& bagFilename) {
+  return bagFilename + ".idx";
+}
+
+bool BagIndex::isReady() const {
+  return _ready;
+}
+
+const std::string& BagIndex::getError() const {
+  return _error;
+}
+
+ros::Time BagIndex::getRestoreTime(const ros::Time& time) const {
+  ros::Time restoreTime = time;
+  if (!_ready)
+    return restoreTime;
+  for (auto it = _keys.cbegin(); it != _keys.cend(); ++it) {
+    auto keyIt = std::upper_bound(it->second.cbegin(), it->second.cend(),
+      time, [](const ros::Time& time, const Key& key) {
+        return time < key.time;
+      });
+    if (keyIt != it->second.cbegin())
+      restoreTime = std::min(restoreTime, (keyIt - 1)->restoreTime);
+  }
+  return restoreTime;
+}
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+void BagIndex::load(const std::string& bagFilename) {
+  stop();
+  _bagFilename = bagFilename;
+  _error.clear();
+  if (read())
+    _ready = true;
+  else
+    QThread::start(QThread::LowPriority);
+}
+
+void BagIndex::stop() {
+  _stopRequested = true;
+  wait();
+  _stopRequested = false;
+  _ready = false;
+  _keys.clear();
+}
+
+bool BagIndex::read() {
+  QFile file(QString::fromStdString(getIndexFilename(_bagFilename)));
+  const QFileInfo bagInfo(QString::fromStdString(_bagFilename));
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+  QDataStream stream(&file);
+  quint32 version, numTopics;
+  qint64 bagSize;
+  QDateTime bagModified;
+  stream >> version;
+  if (version != _version)
+    return false;
+  stream >> bagSize >> bagModified >> numTopics;
+  if ((bagSize != bagInfo.size()) || (bagModified != bagInfo.lastModified()))
+    return false;
+  for (size_t i = 0; i < numTopics; ++i) {
+    QString topic;
+    quint32 numKeys;
+    stream >> topic >> numKeys;
+    Keys& keys = _keys[topic.toStdString()];
+    keys.resize(numKeys);
+    for (auto it = keys.begin(); it != keys.end(); ++it)
+      stream >> it->time.sec >> it->time.nsec >> it->restoreTime.sec >>
+        it->restoreTime.nsec;
+  }
+  if (stream.status() != QDataStream::Ok) {
+    _keys.clear();
+    return false;
+  }
+  return true;
+}
+
+bool BagIndex::write() const {
+  QFile file(QString::fromStdString(getIndexFilename(_bagFilename)));
+  const QFileInfo bagInfo(QString::fromStdString(_bagFilename));
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+  QDataStream stream(&file);
+  stream << (quint32)_version << (qint64)bagInfo.size() <<
+    bagInfo.lastModified() << (quint32)_keys.size();
+  for (auto it = _keys.cbegin(); it != _keys.cend(); ++it) {
+    stream << QString::fromStdString(it->first) <<
+      (quint32)it->second.size();
+    for (auto keyIt = it->second.cbegin(); keyIt != it->second.cend();
+        ++keyIt)
+      stream << keyIt->time.sec << keyIt->time.nsec <<
+        keyIt->restoreTime.sec << keyIt->restoreTime.nsec;
+  }
+  return stream.status() == QDataStream::Ok;
+}
+
+void BagIndex::run() {
+  std::map<std::string, ros::Time> revolutionTimes;
+  std::map<std::string, double> lastStartAngles;
+  VelodyneDecoder::Buffer buffer;
+  DataPacket dataPacket;
+  try {
+    rosbag::Bag bag(_bagFilename);
+    std::vector<std::string> types;
+    types.push_back(
+      ros::message_traits::datatype<velodyne::BinarySnappyMsg>());
+    types.push_back(ros::message_traits::datatype<
+      poslv::VehicleNavigationSolutionMsg>());
+    rosbag::View view(bag, rosbag::TypeQuery(types));
+    for (auto it = view.begin(); !_stopRequested && (it != view.end());
+        ++it) {
+      Keys& keys = _keys[it->getTopic()];
+      Key key;
+      key.time = it->getTime();
+      if (it->isType<velodyne::BinarySnappyMsg>()) {
+        velodyne::BinarySnappyMsgConstPtr msg =
+          it->instantiate<velodyne::BinarySnappyMsg>();
+        if (!VelodyneDecoder::parse(*msg, buffer, dataPacket))
+          continue;
+        const double startAngle =
+          dataPacket.getDataChunk(0).mRotationalInfo;
+        const double endAngle = dataPacket.getDataChunk(
+          DataPacket::mDataChunkNbr - 1).mRotationalInfo;
+        auto angleIt = lastStartAngles.find(it->getTopic());
+        if (angleIt == lastStartAngles.end())
+          revolutionTimes[it->getTopic()] = key.time;
+        else if (angleIt->second > endAngle || startAngle > endAngle) {
+          key.restoreTime = revolutionTimes[it->getTopic()];
+          keys.push_back(key);
+          revolutionTimes[it->getTopic()] = key.time;
+        }
+        lastStartAngles[it->getTopic()] = startAngle;
+      }
+      else if (keys.empty() ||
+          (key.time - keys.back().time).toSec() >= _poseKeySpacing) {
+        key.restoreTime = key.time;
+        keys.push_back(key);
+      }
+    }
+  }
+  catch (std::exception& e) {
+    _error = e.what();
+  }
+  if (!_stopRequested && _error.empty()) {
+    write();
+    _ready = true;
+  }
+}
@@ -0,0 +1,140 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file BagIndex.h
+    \brief This file defines a persistent seek index for ROS bag files.
+  */
+
+#ifndef BAGINDEX_H
+#define BAGINDEX_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+
+#include <QtCore/QThread>
+
+#include <ros/time.h>
+
+/** The BagIndex class indexes a ROS bag file for seeking. For every time, it
+    knows from which earlier time the bag has to be replayed to restore the
+    state of the controls: the latest POS LV pose and the last full Velodyne
+    revolution. Building the index requires decoding all Velodyne packets,
+    so it is done once in a background thread and cached next to the bag
+    file, e.g. foo.bag.idx for foo.bag.
+    \brief Persistent seek index for ROS bag files.
+  */
+class BagIndex :
+  public QThread {
+  /** \name Private constructors
+    @{
+    */
+  /// Copy constructor
+  BagIndex(const BagIndex& other);
+  /// Assignment operator
+  BagIndex& operator = (const BagIndex& other);
+  /** @}
+    */
+
+public:
+  /** \name Types definitions
+    @{
+    */
+  /// Index key for one topic
+  struct Key {
+    /// Time of the key message
+    ros::Time time;
+    /// Time from which to replay to restore the state at the key message
+    ros::Time restoreTime;
+  };
+  /// Index keys of one topic, sorted by time
+  typedef std::vector<Key> Keys;
+  /** @}
+    */
+
+  /** \name Constructors/destructor
+    @{
+    */
+  /// Constructs the index
+  BagIndex();
+  /// Destructor
+  ~BagIndex();
+  /** @}
+    */
+
+  /** \name Accessors
+    @{
+    */
+  /// Returns the file name the index of a bag file is cached in
+  static std::string getIndexFilename(const std::string& bagFilename);
+  /// Returns true if the index is loaded or built
+  bool isReady() const;
+  /// Returns the last error encountered while building
+  const std::string& getError() const;
+  /// Returns the time from which to replay to restore the state at a time
+  ros::Time getRestoreTime(const ros::Time& time) const;
+  /** @}
+    */
+
+  /** \name Methods
+    @{
+    */
+  /// Loads the cached index of a bag file, or builds it in the background
+  void load(const std::string& bagFilename);
+  /// Stops building and drops the index
+  void stop();
+  /** @}
+    */
+
+protected:
+  /** \name Protected methods
+    @{
+    */
+  /// Thread body
+  virtual void run();
+  /// Reads the index from its cache file, returns false if invalid
+  bool read();
+  /// Writes the index to its cache file, returns false on failure
+  bool write() const;
+  /** @}
+    */
+
+  /** \name Protected members
+    @{
+    */
+  /// Indexed bag file name
+  std::string _bagFilename;
+  /// Index keys indexed by topic
+  std::map<std::string, Keys> _keys;
+  /// Stop request for the thread
+  std::atomic<bool> _stopRequested;
+  /// Index loaded or built
+  std::atomic<bool> _ready;
+  /// Last error
+  std::string _error;
+  /// Minimum spacing between two pose keys in seconds
+  static const double _poseKeySpacing;
+  /// Version of the cache file format
+  static const unsigned int _version;
+  /** @}
+    */
+
+};
+
+#endif // BAGINDEX_H
@@ -0,0 +1,109 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include "gui/BagReader.h"
+
+#include <exception>
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+BagReader::BagReader(size_t prefetchSize) :
+    _queue(prefetchSize),
+    _stopRequested(false),
+    _endReached(true) {
+}
+
+BagReader::~BagReader() {
+  stop();
+}
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+size_t BagReader::getNumPrefetched() const {
+  return _queue.getSize();
+}
+
+bool BagReader::isEndReached() const {
+  return _endReached;
+}
+
+const std::string& BagReader::getError() const {
+  return _error;
+}
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+void BagReader::start(const rosbag::View::iterator& begin,
+    const rosbag::View::iterator& end) {
+  stop();
+  _currIt.reset(new rosbag::View::iterator(begin));
+  _endIt.reset(new rosbag::View::iterator(end));
+  _error.clear();
+  _endReached = false;
+  QThread::start();
+}
+
+void BagReader::stop() {
+  _stopRequested = true;
+  wait();
+  _stopRequested = false;
+  _queue.clear();
+  _endReached = true;
+}
+
+bool BagReader::pop(BagMessage& message) {
+  return _queue.pop(message);
+}
+
+bool BagReader::waitPop(BagMessage& message) {
+  while (!_queue.pop(message)) {
+    if (isDone())
+      return false;
+    msleep(1);
+  }
+  return true;
+}
+
+bool BagReader::isDone() const {
+  return _endReached && _queue.isEmpty();
+}
+
+void BagReader::run() {
+  try {
+    while (!_stopRequested && (*_currIt) != (*_endIt)) {
+      BagMessage message;
+      message.topic = (*_currIt)->getTopic();
+      message.time = (*_currIt)->getTime();
+      message.message =
+        (*_currIt)->instantiate<topic_tools::ShapeShifter>();
+      while (!_stopRequested && !_queue.push(message))
+        msleep(1);
+      (*_currIt)++;
+    }
+  }
+  catch (std::exception& e) {
+    _error = e.what();
+  }
+  _endReached = true;
+}
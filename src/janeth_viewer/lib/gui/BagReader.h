@@ -0,0 +1,137 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file BagReader.h
+    \brief This file defines a threaded reader for ROS bag files.
+  */
+
+#ifndef BAGREADER_H
+#define BAGREADER_H
+
+#include <memory>
+#include <string>
+#include <atomic>
+
+#include <QtCore/QThread>
+
+#include <rosbag/view.h>
+
+#include <topic_tools/shape_shifter.h>
+
+#include "utils/LockFreeQueue.h"
+
+/** The BagMessage structure holds a message prefetched from a ROS bag file.
+    \brief Prefetched ROS bag message.
+  */
+struct BagMessage {
+  /// Topic the message was recorded on
+  std::string topic;
+  /// Recording time of the message
+  ros::Time time;
+  /// Message read from the bag, not yet deserialized
+  topic_tools::ShapeShifter::ConstPtr message;
+};
+
+/** The BagReader class walks a ROS bag view in a background thread and
+    fills a bounded queue with the messages read, such that disk reads and
+    chunk decompression do not happen on the GUI thread.
+    \brief Threaded reader for ROS bag files.
+  */
+class BagReader :
+  public QThread {
+  /** \name Private constructors
+    @{
+    */
+  /// Copy constructor
+  BagReader(const BagReader& other);
+  /// Assignment operator
+  BagReader& operator = (const BagReader& other);
+  /** @}
+    */
+
+public:
+  /** \name Constructors/destructor
+    @{
+    */
+  /// Constructs the reader with a given prefetch size
+  BagReader(size_t prefetchSize = 256);
+  /// Destructor
+  ~BagReader();
+  /** @}
+    */
+
+  /** \name Accessors
+    @{
+    */
+  /// Returns the number of prefetched messages
+  size_t getNumPrefetched() const;
+  /// Returns true if the end of the view was reached
+  bool isEndReached() const;
+  /// Returns the last error encountered while reading
+  const std::string& getError() const;
+  /** @}
+    */
+
+  /** \name Methods
+    @{
+    */
+  /// Starts reading between two iterators of a view
+  void start(const rosbag::View::iterator& begin,
+    const rosbag::View::iterator& end);
+  /// Stops reading and drops the prefetched messages
+  void stop();
+  /// Pops a prefetched message, returns false if none is available
+  bool pop(BagMessage& message);
+  /// Pops a prefetched message, waiting for it to be read, returns false
+  /// if all messages were read
+  bool waitPop(BagMessage& message);
+  /// Returns true if all messages were read and popped
+  bool isDone() const;
+  /** @}
+    */
+
+protected:
+  /** \name Protected methods
+    @{
+    */
+  /// Thread body
+  virtual void run();
+  /** @}
+    */
+
+  /** \name Protected members
+    @{
+    */
+  /// Prefetched messages
+  LockFreeQueue<BagMessage> _queue;
+  /// Current iterator of the view
+  std::shared_ptr<rosbag::View::iterator> _currIt;
+  /// End iterator of the view
+  std::shared_ptr<rosbag::View::iterator> _endIt;
+  /// Stop request for the thread
+  std::atomic<bool> _stopRequested;
+  /// End of the view reached
+  std::atomic<bool> _endReached;
+  /// Last error
+  std::string _error;
+  /** @}
+    */
+
+};
+
+#endif // BAGREADER_H
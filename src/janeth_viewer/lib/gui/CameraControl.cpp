@@ -18,14 +18,20 @@
 
 #include "gui/CameraControl.h"
 
-#include <libsnappy/snappy.h>
+#include <algorithm>
 
-#include "gui/BagControl.h"
+#include "gui/MessageDispatcher.h"
 #include "gui/RosControl.h"
 #include "gui/PoslvControl.h"
 
 #include "ui_CameraControl.h"
 
+/******************************************************************************/
+/* Statics                                                                    */
+/******************************************************************************/
+
+const qint64 CameraControl::_adaptationPeriod = 500;
+
 /******************************************************************************/
 /* Constructors and Destructor                                                */
 /******************************************************************************/
@@ -41,14 +47,26 @@ CameraControl::CameraControl(const std::string& serial,
     _serial(serial),
     _imageWidth(0),
     _imageHeight(0),
-    _imageId(0) {
+    _imageId(0),
+    _decodedImageId(0),
+    _renderingCount(0),
+    _adaptedRate(1) {
   _ui->setupUi(this);
+  setObjectName(_serial.c_str());
   _ui->colorChooser->setPalette(&_palette);
   connect(&_palette, SIGNAL(colorChanged(const QString&, const QColor&)),
     this, SLOT(colorChanged(const QString&, const QColor&)));
   connect<View>(SIGNAL(render(View&)), SLOT(renderView(View&)));
-  connect<BagControl>(SIGNAL(messageRead(const rosbag::MessageInstance&)),
-    SLOT(messageRead(const rosbag::MessageInstance&)));
+  connect(&_decoder, SIGNAL(imageDecoded(const QImage&, size_t)), this,
+    SLOT(imageDecoded(const QImage&, size_t)));
+  MessageDispatcher::getInstance().registerReceiver<
+    mv_cameras::ImageSnappyMsg>(this,
+    [this](const mv_cameras::ImageSnappyMsgConstPtr& msg) {
+      this->messageRead(msg);
+    }, "/" + _serial + "_link", "/mv_cameras_manager/" + _serial +
+    "/image_snappy");
+  connect(&MessageDispatcher::getInstance(), SIGNAL(seeked()),
+    this, SLOT(seeked()));
   connect<RosControl>(
     SIGNAL(messageRead(const mv_cameras::ImageSnappyMsgConstPtr&)),
     SLOT(messageRead(const mv_cameras::ImageSnappyMsgConstPtr&)));
@@ -57,13 +75,12 @@ CameraControl::CameraControl(const std::string& serial,
   setShowImage(showImage);
   setAxesColor(Qt::red);
   setShowAxes(showAxes);
-  _grayscaleColorTable.resize(std::numeric_limits<unsigned char>::max() + 1);
-  for (size_t i = 0; i < _grayscaleColorTable.size(); ++i)
-    _grayscaleColorTable[i] = qRgb(i, i, i);
   setRenderingRate(1);
+  setAdaptiveRate(false);
 }
 
 CameraControl::~CameraControl() {
+  MessageDispatcher::getInstance().unregisterReceivers(this);
   delete _ui;
 }
 
@@ -73,6 +90,7 @@ CameraControl::~CameraControl() {
 
 void CameraControl::setShowImage(bool showImage) {
   _ui->showImageCheckBox->setChecked(showImage);
+  MessageDispatcher::getInstance().setReceiversEnabled(this, showImage);
   emit updateViews();
 }
 
@@ -104,6 +122,19 @@ void CameraControl::setRenderingRate(size_t rate) {
   _ui->rateSpinBox->setValue(rate);
 }
 
+size_t CameraControl::getRenderingRate() const {
+  if (_ui->adaptiveRateCheckBox->isChecked())
+    return std::max<size_t>(_adaptedRate, _ui->rateSpinBox->value());
+  else
+    return _ui->rateSpinBox->value();
+}
+
+void CameraControl::setAdaptiveRate(bool adaptiveRate) {
+  _ui->adaptiveRateCheckBox->setChecked(adaptiveRate);
+  _adaptedRate = _ui->rateSpinBox->value();
+  _adaptationTimer.start();
+}
+
 /******************************************************************************/
 /* Methods                                                                    */
 /******************************************************************************/
@@ -128,13 +159,40 @@ void CameraControl::renderAxes(View& view, const QColor& color,
   view.render(QString(_serial.c_str()), labelPosition, color, 0.2 * length);
 }
 
+void CameraControl::adaptRenderingRate(const View& view) {
+  if (view.getFrameRate() <= 0.0 || view.getFrameTime() <= 0.0 ||
+      _adaptationTimer.elapsed() < _adaptationPeriod)
+    return;
+  const double frameBudget = 1e3 / view.getFrameRate();
+  const size_t minRate = _ui->rateSpinBox->value();
+  const size_t maxRate = _ui->rateSpinBox->maximum();
+  _adaptedRate = std::max(_adaptedRate, minRate);
+  if (view.getFrameTime() > frameBudget && _adaptedRate < maxRate)
+    ++_adaptedRate;
+  else if (view.getFrameTime() < 0.5 * frameBudget && _adaptedRate > minRate)
+    --_adaptedRate;
+  _adaptationTimer.start();
+}
+
 void CameraControl::renderImage(View& view) {
   if (_imageHeight && _imageWidth) {
-    QImage image(reinterpret_cast<const unsigned char*>(_imageData.c_str()),
-      _imageWidth, _imageHeight, QImage::Format_Indexed8);
-    image.setColorTable(_grayscaleColorTable);
+    QImage image;
+    if (view.needsImage(_serial, _imageId)) {
+      const QSize size = view.getImageSize();
+      const QSize imageSize = size.isValid() ? size :
+        QSize(_imageWidth, _imageHeight);
+      if (_decodedImageId == _imageId)
+        for (auto it = _images.begin(); it != _images.end(); ++it)
+          if (it->size() == imageSize) {
+            image = *it;
+            break;
+          }
+      if (image.isNull() && _imageMsg &&
+          !_decoder.isPending(_imageId, size))
+        _decoder.push(_imageMsg, _imageId, size);
+    }
     view.render(image, QRectF(0, 0, _imageWidth / 1000.0,
-      _imageHeight / 1000.0), _T_w_i, _serial, _imageId);
+      _imageHeight / 1000.0), _T_w_i * _T_i_c, _serial, _imageId);
   }
 }
 
@@ -147,38 +205,31 @@ void CameraControl::showImageToggled(bool checked) {
 }
 
 void CameraControl::renderView(View& view) {
-  if (_ui->showImageCheckBox->isChecked())
+  view.beginTiming(*this);
+  if (_ui->showImageCheckBox->isChecked()) {
+    if (_ui->adaptiveRateCheckBox->isChecked())
+      adaptRenderingRate(view);
     renderImage(view);
+  }
   if (_ui->showAxesCheckBox->isChecked())
     renderAxes(view, _palette.getColor("Axes"), 0.5);
+  view.endTiming();
 }
 
 void CameraControl::messageRead(const mv_cameras::ImageSnappyMsgConstPtr& msg) {
   if (msg->header.frame_id == ("/" + _serial + "_link")) {
-    static size_t renderingCount = 0;
-    renderingCount++;
-    if (renderingCount >= _ui->rateSpinBox->value()) {
-      std::string uncompressedData;
-      snappy::Uncompress(reinterpret_cast<const char*>(msg->data.data()),
-        msg->data.size(), &uncompressedData);
+    _renderingCount++;
+    if (_renderingCount >= getRenderingRate()) {
+      _imageMsg = msg;
       _imageWidth = msg->width;
       _imageHeight = msg->height;
-      _imageData = uncompressedData;
       _imageId = msg->header.seq;
       emit updateViews();
-      renderingCount = 0;
+      _renderingCount = 0;
     }
   }
 }
 
-void CameraControl::messageRead(const rosbag::MessageInstance& message) {
-  if (message.isType<mv_cameras::ImageSnappyMsg>()) {
-    mv_cameras::ImageSnappyMsgPtr imageSnappyMsg(
-      message.instantiate<mv_cameras::ImageSnappyMsg>());
-    messageRead(imageSnappyMsg);
-  }
-}
-
 void CameraControl::showAxesToggled(bool checked) {
   setShowAxes(checked);
 }
@@ -192,3 +243,32 @@ void CameraControl::transformationChanged() {
 void CameraControl::poseUpdate(const Eigen::Affine3d& T_w_i) {
   _T_w_i = T_w_i;
 }
+
+void CameraControl::adaptiveRateToggled(bool checked) {
+  setAdaptiveRate(checked);
+}
+
+void CameraControl::imageDecoded(const QImage& image, size_t imageId) {
+  if (imageId != _decodedImageId) {
+    _images.clear();
+    _decodedImageId = imageId;
+  }
+  auto it = _images.begin();
+  while (it != _images.end() && it->size() != image.size())
+    ++it;
+  if (it != _images.end())
+    *it = image;
+  else
+    _images.push_back(image);
+  emit updateViews();
+}
+
+void CameraControl::seeked() {
+  _decoder.clear();
+  _imageMsg.reset();
+  _images.clear();
+  _imageWidth = 0;
+  _imageHeight = 0;
+  _renderingCount = 0;
+  emit updateViews();
+}
@@ -23,13 +23,16 @@
 #ifndef CAMERACONTROL_H
 #define CAMERACONTROL_H
 
-#include <rosbag/message_instance.h>
+#include <vector>
+
+#include <QtCore/QElapsedTimer>
 
 #include <mv_cameras/ImageSnappyMsg.h>
 
 #include "gui/palette.h"
 #include "gui/view.h"
 #include "gui/control.h"
+#include "gui/ImageDecoder.h"
 
 class Ui_CameraControl;
 
@@ -76,6 +79,10 @@ public:
     double rx);
   /// Sets the rendering rate
   void setRenderingRate(size_t rate);
+  /// Returns the effective rendering rate
+  size_t getRenderingRate() const;
+  /// Adapts the rendering rate to the frame budget of the views
+  void setAdaptiveRate(bool adaptiveRate);
   /** @}
     */
 
@@ -83,6 +90,8 @@ protected:
   /** \name Protected methods
     @{
     */
+  /// Adapts the rendering rate to the frame time of a view
+  void adaptRenderingRate(const View& view);
   /// Render the current image
   void renderImage(View& view);
   /// Render the current axes
@@ -107,12 +116,24 @@ protected:
   size_t _imageWidth;
   /// Image height
   size_t _imageHeight;
-  /// Image data
-  std::string _imageData;
+  /// Latest compressed image message
+  mv_cameras::ImageSnappyMsgConstPtr _imageMsg;
   /// Image id
   size_t _imageId;
-  /// Grayscale color table
-  QVector<QRgb> _grayscaleColorTable;
+  /// Image decoder
+  ImageDecoder _decoder;
+  /// Latest decoded image, once per size requested by the views
+  std::vector<QImage> _images;
+  /// Id of the latest decoded image
+  size_t _decodedImageId;
+  /// Number of messages received since the last rendered one
+  size_t _renderingCount;
+  /// Rendering rate adapted to the frame budget
+  size_t _adaptedRate;
+  /// Time since the last rate adaptation
+  QElapsedTimer _adaptationTimer;
+  /// Minimum period between two rate adaptations in [ms]
+  static const qint64 _adaptationPeriod;
   /** @}
     */
 
@@ -126,8 +147,6 @@ protected slots:
   void showImageToggled(bool checked);
   /// Render the current view  
   void renderView(View& view);
-  /// New message read from the bag file
-  void messageRead(const rosbag::MessageInstance& message);
   /// Camera message received
   void messageRead(const mv_cameras::ImageSnappyMsgConstPtr& msg);
   /// Pose update
@@ -136,6 +155,12 @@ protected slots:
   void showAxesToggled(bool checked);
   /// Transformation changed
   void transformationChanged();
+  /// Image decoded
+  void imageDecoded(const QImage& image, size_t imageId);
+  /// Adaptive rate toggled
+  void adaptiveRateToggled(bool checked);
+  /// Message stream seeked
+  void seeked();
   /** @}
     */
 
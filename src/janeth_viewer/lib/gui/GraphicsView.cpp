@@ -53,18 +53,6 @@ GraphicsView::Size GraphicsView::getSize() const {
   return Size(getDisplay().rect().width(), getDisplay().rect().height());
 }
 
-void GraphicsView::setProjection(const Projection& projection) {
-}
-
-GraphicsView::Projection GraphicsView::getProjection() const {
-}
-
-void GraphicsView::setTransformation(const Transformation& transformation) {
-}
-
-GraphicsView::Transformation GraphicsView::getTransformation() const {
-}
-
 GraphicsDisplay& GraphicsView::getDisplay() {
   return *_ui->display;
 }
@@ -100,24 +88,6 @@ void GraphicsView::setDumpAll(bool dumpAll) {
 /* Methods                                                                    */
 /******************************************************************************/
 
-void GraphicsView::saveTransformation() {
-}
-
-void GraphicsView::restoreTransformation() {
-}
-
-void GraphicsView::transform(const Transformation& transformation) {
-}
-
-void GraphicsView::translate(const Translation& translation) {
-}
-
-void GraphicsView::rotate(const Rotation& rotation) {
-}
-
-void GraphicsView::scale(const Scale& scale) {
-}
-
 void GraphicsView::clear(const QColor& color) {
 }
 
@@ -134,6 +104,10 @@ void GraphicsView::render(const Points<double, 3>& vertices, const
     toColor, double fromSize, double toSize, bool smooth) {
 }
 
+void GraphicsView::render(const PointCloud<float>& cloud, const QColor& color,
+    double size, bool smooth) {
+}
+
 void GraphicsView::render(const Line<double, 3>& edges, const QColor& color) {
 }
 
@@ -147,33 +121,50 @@ void GraphicsView::render(const QString& text, const QColor& color) {
 void GraphicsView::render(const QImage& image, const QRectF& target,
     const Transformation& transformation, const std::string& serial,
     size_t imageId) {
+  if (!_imagesMap.count(serial)) {
+    if (image.isNull())
+      return;
+    _imagesMap[serial] = std::make_pair(imageId,
+      getDisplay().getScene().addPixmap(QPixmap()));
+    _imagesMap[serial].second->setZValue(0.7);
+    _labelsMap[serial] = getDisplay().getScene().addText(serial.c_str());
+    _labelsMap[serial]->setDefaultTextColor(Qt::red);
+    _labelsMap[serial]->setZValue(0.8);
+    layoutImages();
+  }
+  if (!image.isNull() && needsImage(serial, imageId)) {
+    if (image.size() == getImageSize())
+      _imagesMap[serial].second->setPixmap(QPixmap::fromImage(image));
+    else
+      _imagesMap[serial].second->setPixmap(QPixmap::fromImage(
+        image.scaled(getImageSize())));
+    _imagesMap[serial].first = imageId;
+  }
+}
+
+bool GraphicsView::needsImage(const std::string& serial, size_t imageId)
+    const {
+  auto it = _imagesMap.find(serial);
+  return it == _imagesMap.end() || it->second.first != imageId ||
+    it->second.second->pixmap().size() != getImageSize();
+}
+
+QSize GraphicsView::getImageSize() const {
+  return QSize(getSize()(0) / 4, getSize()(1) / 2);
+}
+
+void GraphicsView::layoutImages() {
   const double displayWidth = getSize()(0);
   const double displayHeight = getSize()(1);
   double imageWidth = displayWidth / 4.0;
   double imageHeight = displayHeight / 2.0;
-  if (_imagesMap.count(serial) && _imagesMap[serial].first != imageId) {
-    getDisplay().getScene().removeItem(_imagesMap[serial].second);
-    delete _imagesMap[serial].second;
-  }
-  if (!_imagesMap.count(serial) || _imagesMap[serial].first != imageId) {
-    QImage imageScaled(image.scaled(imageWidth, imageHeight));
-    _imagesMap[serial] = std::make_pair(imageId,
-      getDisplay().getScene().addPixmap(QPixmap::fromImage(imageScaled)));
-  }
-  if (!_labelsMap.count(serial)) {
-    _labelsMap[serial] =
-      getDisplay().getScene().addText(serial.c_str());
-    _labelsMap[serial]->setDefaultTextColor(Qt::red);
-  }
   double x = -displayWidth / 2.0;
   double y = -displayHeight / 2.0;
   size_t col = 0;
   size_t row = 0;
   for (auto it = _imagesMap.cbegin(); it != _imagesMap.cend(); ++it) {
     it->second.second->setPos(x, y);
-    it->second.second->setZValue(0.7);
     _labelsMap[it->first]->setPos(x + 20, y + 20);
-    _labelsMap[it->first]->setZValue(0.8);
     if (col == 3) {
       col = 0;
       row++;
@@ -240,4 +231,5 @@ void GraphicsView::update() {
 
 void GraphicsView::resized() {
   setDumpFrameSize(getDisplay().rect().width(), getDisplay().rect().height());
+  layoutImages();
 }
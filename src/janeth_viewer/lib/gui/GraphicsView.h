@@ -65,14 +65,6 @@ public:
     */
   /// Returns the size of the view
   Size getSize() const;
-  /// Sets the projection
-  void setProjection(const Projection& projection);
-  /// Returns the projection
-  Projection getProjection() const;
-  /// Sets the transformation
-  void setTransformation(const Transformation& transformation);
-  /// Returns the transformation
-  Transformation getTransformation() const;
   /// Returns the display
   GraphicsDisplay& getDisplay();
   /// Returns the display
@@ -91,18 +83,6 @@ public:
   /** \name Methods
     @{
     */
-  /// Saves the transformation
-  void saveTransformation();
-  /// Restores the transformation
-  void restoreTransformation();
-  /// Transforms the view
-  void transform(const Transformation& transformation);
-  /// Translates the view
-  void translate(const Translation& translation);
-  /// Rotates the view
-  void rotate(const Rotation& rotation);
-  /// Scales the view
-  void scale(const Scale& scale);
   /// Clears the color
   void clear(const QColor& color);
   /// Enable fog
@@ -114,6 +94,9 @@ public:
   void render(const Points<double, 3>& vertices, const
     std::vector<double>& weights, const QColor& fromColor, const QColor&
     toColor, double fromSize, double toSize, bool smooth);
+  /// Renders a point cloud
+  void render(const PointCloud<float>& cloud, const QColor& color,
+    double size, bool smooth);
   /// Renders lines
   void render(const Line<double, 3>& edges, const QColor& color);
   /// Renders lines with weights
@@ -125,6 +108,10 @@ public:
   void render(const QImage& image, const QRectF& target,
     const Transformation& transformation, const std::string& serial,
     size_t imageId);
+  /// Returns true if an image is not displayed yet at the tile size
+  bool needsImage(const std::string& serial, size_t imageId) const;
+  /// Returns the size of an image tile
+  QSize getImageSize() const;
   /** @}
     */
 
@@ -134,6 +121,8 @@ protected:
   /** \name Protected methods
     @{
     */
+  /// Lays out the image tiles in the display
+  void layoutImages();
   /// Dump a frame
   bool dumpFrame(const QString& filename, size_t width, size_t height);
   /** @}
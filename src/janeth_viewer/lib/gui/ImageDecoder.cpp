@@ -0,0 +1,141 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include "gui/ImageDecoder.h"
+
+#include <limits>
+#include <vector>
+
+#include <QtCore/QThreadStorage>
+#include <QtCore/QtConcurrentRun>
+
+#include <libsnappy/snappy.h>
+
+/******************************************************************************/
+/* Statics                                                                    */
+/******************************************************************************/
+
+const QVector<QRgb> ImageDecoder::_grayColorTable =
+  ImageDecoder::getGrayColorTable();
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+ImageDecoder::ImageDecoder() {
+  connect(&_watcher, SIGNAL(finished()), this, SLOT(finished()));
+}
+
+ImageDecoder::~ImageDecoder() {
+  clear();
+}
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+bool ImageDecoder::isPending(size_t imageId, const QSize& size) const {
+  for (auto it = _next.begin(); it != _next.end(); ++it)
+    if (it->size == size)
+      return it->imageId == imageId;
+  return _watcher.isRunning() && _current.imageId == imageId &&
+    _current.size == size;
+}
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+void ImageDecoder::push(const mv_cameras::ImageSnappyMsgConstPtr& msg,
+    size_t imageId, const QSize& size) {
+  Request request;
+  request.msg = msg;
+  request.imageId = imageId;
+  request.size = size;
+  if (_watcher.isRunning()) {
+    for (auto it = _next.begin(); it != _next.end(); ++it)
+      if (it->size == size) {
+        *it = request;
+        return;
+      }
+    _next.push_back(request);
+  }
+  else
+    start(request);
+}
+
+void ImageDecoder::clear() {
+  _next.clear();
+  _watcher.waitForFinished();
+}
+
+void ImageDecoder::start(const Request& request) {
+  _current = request;
+  _watcher.setFuture(QtConcurrent::run(&ImageDecoder::decode, request));
+}
+
+QImage ImageDecoder::decode(const Request& request) {
+  static QThreadStorage<std::vector<char>*> buffers;
+  if (!buffers.hasLocalData())
+    buffers.setLocalData(new std::vector<char>());
+  std::vector<char>& buffer = *buffers.localData();
+  const size_t width = request.msg->width;
+  const size_t height = request.msg->height;
+  const char* compressedData =
+    reinterpret_cast<const char*>(request.msg->data.data());
+  size_t uncompressedSize = 0;
+  bool uncompressed = false;
+  if (snappy::GetUncompressedLength(compressedData, request.msg->data.size(),
+      &uncompressedSize) && uncompressedSize >= width * height) {
+    buffer.resize(uncompressedSize);
+    uncompressed = snappy::RawUncompress(compressedData,
+      request.msg->data.size(), buffer.data());
+  }
+  // A corrupt frame is shown black rather than from a previous frame left in
+  // the buffer
+  if (!uncompressed)
+    buffer.assign(width * height, 0);
+  // The image wraps the buffer without copying it, the conversion below
+  // writes the only copy
+  QImage image(reinterpret_cast<unsigned char*>(buffer.data()), width,
+    height, width, QImage::Format_Indexed8);
+  image.setColorTable(_grayColorTable);
+  QImage rgbImage = image.convertToFormat(QImage::Format_RGB32);
+  if (request.size.isValid() && request.size != rgbImage.size())
+    return rgbImage.scaled(request.size, Qt::IgnoreAspectRatio,
+      Qt::SmoothTransformation);
+  else
+    return rgbImage;
+}
+
+QVector<QRgb> ImageDecoder::getGrayColorTable() {
+  QVector<QRgb> colorTable(std::numeric_limits<unsigned char>::max() + 1);
+  for (int i = 0; i < colorTable.size(); ++i)
+    colorTable[i] = qRgb(i, i, i);
+  return colorTable;
+}
+
+void ImageDecoder::finished() {
+  if (!_watcher.isCanceled())
+    emit imageDecoded(_watcher.result(), _current.imageId);
+  if (!_next.empty()) {
+    const Request next = _next.front();
+    _next.pop_front();
+    start(next);
+  }
+}
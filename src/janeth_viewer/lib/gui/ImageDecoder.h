@@ -0,0 +1,149 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file ImageDecoder.h
+    \brief This file defines a parallel decoder for camera images.
+  */
+
+#ifndef IMAGEDECODER_H
+#define IMAGEDECODER_H
+
+#include <deque>
+
+#include <QtCore/QObject>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QVector>
+#include <QtGui/QImage>
+
+#include <mv_cameras/ImageSnappyMsg.h>
+
+/** The ImageDecoder class decompresses snappy camera images and scales them
+    to a requested size on the Qt global thread pool, so that a view only has
+    to swap the result in. At most one image is decoded at a time per
+    decoder: an image pushed while another one is in flight replaces any
+    image of the same size still waiting, so that a slow pool skips frames
+    instead of lagging behind, while views requesting different sizes are
+    all served in turn.
+    \brief Parallel decoder for camera images.
+  */
+class ImageDecoder :
+  public QObject {
+Q_OBJECT
+  /** \name Private constructors
+    @{
+    */
+  /// Copy constructor
+  ImageDecoder(const ImageDecoder& other);
+  /// Assignment operator
+  ImageDecoder& operator = (const ImageDecoder& other);
+  /** @}
+    */
+
+public:
+  /** \name Constructors/destructor
+    @{
+    */
+  /// Constructs the decoder
+  ImageDecoder();
+  /// Destructor
+  ~ImageDecoder();
+  /** @}
+    */
+
+  /** \name Accessors
+    @{
+    */
+  /// Returns true if the image with the given id and size is being decoded
+  bool isPending(size_t imageId, const QSize& size) const;
+  /** @}
+    */
+
+  /** \name Methods
+    @{
+    */
+  /// Queues an image for decoding, an invalid size keeps the native size
+  void push(const mv_cameras::ImageSnappyMsgConstPtr& msg, size_t imageId,
+    const QSize& size = QSize());
+  /// Waits for the image in flight and drops the images waiting
+  void clear();
+  /** @}
+    */
+
+protected:
+  /** \name Protected types
+    @{
+    */
+  /// Decoding request
+  struct Request {
+    /// Compressed image
+    mv_cameras::ImageSnappyMsgConstPtr msg;
+    /// Image id
+    size_t imageId;
+    /// Requested size
+    QSize size;
+  };
+  /** @}
+    */
+
+  /** \name Protected methods
+    @{
+    */
+  /// Starts decoding a request
+  void start(const Request& request);
+  /// Decodes an image, called from the thread pool
+  static QImage decode(const Request& request);
+  /// Returns the color table mapping 8-bit pixels to gray levels
+  static QVector<QRgb> getGrayColorTable();
+  /** @}
+    */
+
+  /** \name Protected members
+    @{
+    */
+  /// Watcher on the image in flight
+  QFutureWatcher<QImage> _watcher;
+  /// Request in flight
+  Request _current;
+  /// Requests waiting for the image in flight, at most one per size
+  std::deque<Request> _next;
+  /// Color table of the decoded 8-bit images
+  static const QVector<QRgb> _grayColorTable;
+  /** @}
+    */
+
+protected slots:
+  /** \name Qt slots
+    @{
+    */
+  /// Image in flight decoded
+  void finished();
+  /** @}
+    */
+
+signals:
+  /** \name Qt signals
+    @{
+    */
+  /// Image decoded, in the display-ready RGB32 format
+  void imageDecoded(const QImage& image, size_t imageId);
+  /** @}
+    */
+
+};
+
+#endif // IMAGEDECODER_H
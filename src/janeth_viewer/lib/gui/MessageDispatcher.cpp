@@ -0,0 +1,79 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include "gui/MessageDispatcher.h"
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+MessageDispatcher::MessageDispatcher() {
+}
+
+MessageDispatcher::~MessageDispatcher() {
+}
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+MessageDispatcher& MessageDispatcher::getInstance() {
+  static MessageDispatcher instance;
+  return instance;
+}
+
+void MessageDispatcher::setReceiversEnabled(const void* owner, bool enabled) {
+  bool changed = false;
+  for (auto it = _dispatches.begin(); it != _dispatches.end(); ++it)
+    changed |= it->second->setReceiversEnabled(owner, enabled);
+  if (changed)
+    emit receiversChanged();
+}
+
+bool MessageDispatcher::isConsumed(const std::string& topic,
+    const std::string& md5Sum) const {
+  auto it = _dispatches.find(md5Sum);
+  if (it != _dispatches.end())
+    return it->second->isConsumed(topic);
+  else
+    return false;
+}
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+void MessageDispatcher::unregisterReceivers(const void* owner) {
+  for (auto it = _dispatches.begin(); it != _dispatches.end(); ++it)
+    it->second->unregisterReceivers(owner);
+  emit receiversChanged();
+}
+
+bool MessageDispatcher::dispatch(
+    const topic_tools::ShapeShifter::ConstPtr& message,
+    const std::string& topic) const {
+  auto it = _dispatches.find(message->getMD5Sum());
+  if (it != _dispatches.end())
+    return it->second->dispatch(*message, topic);
+  else
+    return false;
+}
+
+void MessageDispatcher::seek() {
+  emit seeked();
+}
@@ -0,0 +1,190 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file MessageDispatcher.h
+    \brief This file defines a type-indexed dispatcher for ROS messages.
+  */
+
+#ifndef MESSAGEDISPATCHER_H
+#define MESSAGEDISPATCHER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+
+#include <QtCore/QObject>
+
+#include <topic_tools/shape_shifter.h>
+
+/** The MessageDispatcher class delivers serialized ROS messages to the
+    receivers registered for their type and, if the message has a header,
+    for their frame identifier. A message is deserialized once, and only if
+    there is an enabled receiver for it. Receivers may also name the topic
+    they listen to, such that readers can skip the topics nobody consumes
+    and messages of other topics are dropped before being deserialized.
+    The dispatcher is meant to be used from the GUI thread only.
+    \brief Type-indexed dispatcher for ROS messages.
+  */
+class MessageDispatcher :
+  public QObject {
+Q_OBJECT
+  /** \name Private constructors
+    @{
+    */
+  /// Constructor
+  MessageDispatcher();
+  /// Copy constructor
+  MessageDispatcher(const MessageDispatcher& other);
+  /// Assignment operator
+  MessageDispatcher& operator = (const MessageDispatcher& other);
+  /** @}
+    */
+
+public:
+  /** \name Constructors/destructor
+    @{
+    */
+  /// Destructor
+  ~MessageDispatcher();
+  /** @}
+    */
+
+  /** \name Accessors
+    @{
+    */
+  /// Returns the instance of the dispatcher
+  static MessageDispatcher& getInstance();
+  /// Enables or disables all receivers of an owner
+  void setReceiversEnabled(const void* owner, bool enabled);
+  /// Returns true if an enabled receiver consumes a topic of a given type
+  bool isConsumed(const std::string& topic, const std::string& md5Sum) const;
+  /** @}
+    */
+
+  /** \name Methods
+    @{
+    */
+  /// Registers a receiver for a message type, optionally for a given frame
+  /// and a given topic
+  template <typename M> void registerReceiver(const void* owner,
+    const std::function<void(const boost::shared_ptr<const M>&)>& receiver,
+    const std::string& frameId = "", const std::string& topic = "");
+  /// Unregisters all receivers of an owner
+  void unregisterReceivers(const void* owner);
+  /// Dispatches a message read from a topic, an empty topic matches any
+  /// receiver, returns false if nobody received it
+  bool dispatch(const topic_tools::ShapeShifter::ConstPtr& message,
+    const std::string& topic = "") const;
+  /// Notifies the receivers that the message stream jumps in time
+  void seek();
+  /** @}
+    */
+
+protected:
+  /** \name Protected types
+    @{
+    */
+  /// Dispatch for one message type
+  class Dispatch {
+  public:
+    /// Destructor
+    virtual ~Dispatch() {};
+    /// Deserializes and delivers a message, returns false if not delivered
+    virtual bool dispatch(const topic_tools::ShapeShifter& message,
+      const std::string& topic) const = 0;
+    /// Unregisters all receivers of an owner
+    virtual void unregisterReceivers(const void* owner) = 0;
+    /// Enables or disables all receivers of an owner, returns true on change
+    virtual bool setReceiversEnabled(const void* owner, bool enabled) = 0;
+    /// Returns true if an enabled receiver consumes a topic
+    virtual bool isConsumed(const std::string& topic) const = 0;
+  };
+  /// Dispatch for the message type M
+  template <typename M> class TypedDispatch :
+    public Dispatch {
+  public:
+    /// Receiver type
+    typedef std::function<void(const boost::shared_ptr<const M>&)> Receiver;
+    /// Registered receiver
+    struct Entry {
+      /// Owner of the receiver
+      const void* owner;
+      /// Receiver
+      Receiver receiver;
+      /// Topic listened to, empty for any
+      std::string topic;
+      /// Enabled flag
+      bool enabled;
+    };
+    /// Registered receivers
+    typedef std::vector<Entry> Receivers;
+    /// Registers a receiver
+    void registerReceiver(const void* owner, const Receiver& receiver,
+      const std::string& frameId, const std::string& topic);
+    /// Deserializes and delivers a message
+    virtual bool dispatch(const topic_tools::ShapeShifter& message,
+      const std::string& topic) const;
+    /// Unregisters all receivers of an owner
+    virtual void unregisterReceivers(const void* owner);
+    /// Enables or disables all receivers of an owner
+    virtual bool setReceiversEnabled(const void* owner, bool enabled);
+    /// Returns true if an enabled receiver consumes a topic
+    virtual bool isConsumed(const std::string& topic) const;
+  protected:
+    /// Returns true if a receiver is enabled and listens to a topic
+    static bool consumes(const Entry& entry, const std::string& topic);
+    /// Returns true if one of the receivers consumes a topic
+    static bool hasConsumer(const Receivers& receivers,
+      const std::string& topic);
+    /// Delivers a message to the receivers consuming its topic
+    static void deliver(const Receivers& receivers,
+      const boost::shared_ptr<const M>& msg, const std::string& topic);
+    /// Receivers for any frame
+    Receivers _receivers;
+    /// Receivers indexed by frame
+    std::unordered_map<std::string, Receivers> _frameReceivers;
+  };
+  /** @}
+    */
+
+  /** \name Protected members
+    @{
+    */
+  /// Dispatches indexed by message MD5 sum
+  std::unordered_map<std::string, std::shared_ptr<Dispatch> > _dispatches;
+  /** @}
+    */
+
+signals:
+  /** \name Qt signals
+    @{
+    */
+  /// Receivers were registered, unregistered, enabled or disabled
+  void receiversChanged();
+  /// The message stream jumped in time, state built from it is stale
+  void seeked();
+  /** @}
+    */
+
+};
+
+#include "gui/MessageDispatcher.tpp"
+
+#endif // MESSAGEDISPATCHER_H
@@ -0,0 +1,148 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include <algorithm>
+
+#include <ros/message_traits.h>
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+template <typename M>
+bool MessageDispatcher::TypedDispatch<M>::setReceiversEnabled(
+    const void* owner, bool enabled) {
+  bool changed = false;
+  for (auto it = _receivers.begin(); it != _receivers.end(); ++it)
+    if (it->owner == owner && it->enabled != enabled) {
+      it->enabled = enabled;
+      changed = true;
+    }
+  for (auto it = _frameReceivers.begin(); it != _frameReceivers.end(); ++it)
+    for (auto itR = it->second.begin(); itR != it->second.end(); ++itR)
+      if (itR->owner == owner && itR->enabled != enabled) {
+        itR->enabled = enabled;
+        changed = true;
+      }
+  return changed;
+}
+
+template <typename M>
+bool MessageDispatcher::TypedDispatch<M>::isConsumed(
+    const std::string& topic) const {
+  if (hasConsumer(_receivers, topic))
+    return true;
+  for (auto it = _frameReceivers.cbegin(); it != _frameReceivers.cend(); ++it)
+    if (hasConsumer(it->second, topic))
+      return true;
+  return false;
+}
+
+template <typename M>
+bool MessageDispatcher::TypedDispatch<M>::consumes(const Entry& entry,
+    const std::string& topic) {
+  return entry.enabled && (topic.empty() || entry.topic.empty() ||
+    entry.topic == topic);
+}
+
+template <typename M>
+bool MessageDispatcher::TypedDispatch<M>::hasConsumer(
+    const Receivers& receivers, const std::string& topic) {
+  for (auto it = receivers.cbegin(); it != receivers.cend(); ++it)
+    if (consumes(*it, topic))
+      return true;
+  return false;
+}
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+template <typename M>
+void MessageDispatcher::registerReceiver(const void* owner,
+    const std::function<void(const boost::shared_ptr<const M>&)>& receiver,
+    const std::string& frameId, const std::string& topic) {
+  const std::string md5Sum = ros::message_traits::md5sum<M>();
+  if (!_dispatches.count(md5Sum))
+    _dispatches[md5Sum].reset(new TypedDispatch<M>());
+  std::static_pointer_cast<TypedDispatch<M> >(_dispatches[md5Sum])->
+    registerReceiver(owner, receiver, frameId, topic);
+  emit receiversChanged();
+}
+
+template <typename M>
+void MessageDispatcher::TypedDispatch<M>::registerReceiver(const void* owner,
+    const Receiver& receiver, const std::string& frameId,
+    const std::string& topic) {
+  Entry entry;
+  entry.owner = owner;
+  entry.receiver = receiver;
+  entry.topic = topic;
+  entry.enabled = true;
+  if (frameId.empty())
+    _receivers.push_back(entry);
+  else
+    _frameReceivers[frameId].push_back(entry);
+}
+
+template <typename M>
+void MessageDispatcher::TypedDispatch<M>::deliver(const Receivers& receivers,
+    const boost::shared_ptr<const M>& msg, const std::string& topic) {
+  for (auto it = receivers.cbegin(); it != receivers.cend(); ++it)
+    if (consumes(*it, topic))
+      it->receiver(msg);
+}
+
+template <typename M>
+bool MessageDispatcher::TypedDispatch<M>::dispatch(
+    const topic_tools::ShapeShifter& message, const std::string& topic) const {
+  // The frame is only known once deserialized, so messages of a topic no
+  // receiver listens to are dropped first
+  if (!isConsumed(topic))
+    return false;
+  boost::shared_ptr<M> msg = message.instantiate<M>();
+  bool delivered = hasConsumer(_receivers, topic);
+  const std::string* frameId = ros::message_traits::frameId(*msg);
+  if (frameId) {
+    auto it = _frameReceivers.find(*frameId);
+    if (it != _frameReceivers.end() && hasConsumer(it->second, topic)) {
+      deliver(it->second, msg, topic);
+      delivered = true;
+    }
+  }
+  deliver(_receivers, msg, topic);
+  return delivered;
+}
+
+template <typename M>
+void MessageDispatcher::TypedDispatch<M>::unregisterReceivers(
+    const void* owner) {
+  auto isOwner = [owner](const Entry& entry) {
+    return entry.owner == owner;
+  };
+  _receivers.erase(std::remove_if(_receivers.begin(), _receivers.end(),
+    isOwner), _receivers.end());
+  for (auto it = _frameReceivers.begin(); it != _frameReceivers.end(); ) {
+    it->second.erase(std::remove_if(it->second.begin(), it->second.end(),
+      isOwner), it->second.end());
+    if (it->second.empty())
+      it = _frameReceivers.erase(it);
+    else
+      ++it;
+  }
+}
@@ -21,7 +21,7 @@
 #include <libposlv/sensor/Utils.h>
 #include <libposlv/geo-tools/Geo.h>
 
-#include "gui/BagControl.h"
+#include "gui/MessageDispatcher.h"
 #include "gui/RosControl.h"
 
 #include "ui_PoslvControl.h"
@@ -43,11 +43,16 @@ PoslvControl::PoslvControl(bool showPath, bool showAxes, bool showVelocity,
       * Eigen::Translation3d(0, 0, 0)) {
   _ui->setupUi(this);
   _ui->colorChooser->setPalette(&_palette);
-  connect<BagControl>(SIGNAL(messageRead(const rosbag::MessageInstance&)),
-    SLOT(messageRead(const rosbag::MessageInstance&)));
+  MessageDispatcher::getInstance().registerReceiver<
+    poslv::VehicleNavigationSolutionMsg>(this,
+    [this](const poslv::VehicleNavigationSolutionMsgConstPtr& msg) {
+      this->messageRead(msg);
+    });
   connect<RosControl>(
     SIGNAL(messageRead(const poslv::VehicleNavigationSolutionMsgConstPtr&)),
     SLOT(messageRead(const poslv::VehicleNavigationSolutionMsgConstPtr&)));
+  connect(&MessageDispatcher::getInstance(), SIGNAL(seeked()),
+    this, SLOT(seeked()));
   connect<View>(SIGNAL(render(View&)), SLOT(renderView(View&)));
   setPathColor(Qt::red);
   setShowPath(showPath);
@@ -60,6 +65,7 @@ PoslvControl::PoslvControl(bool showPath, bool showAxes, bool showVelocity,
 }
 
 PoslvControl::~PoslvControl() {
+  MessageDispatcher::getInstance().unregisterReceivers(this);
   delete _ui;
 }
 
@@ -158,6 +164,17 @@ void PoslvControl::renderAcceleration(View& view, const QColor& color) {
   }
 }
 
+void PoslvControl::clearPath() {
+  _path.clear();
+  _linearVelocity = Eigen::Vector3d::Zero();
+  _angularVelocity = Eigen::Vector3d::Zero();
+  _acceleration = Eigen::Vector3d::Zero();
+  _T_w_i = Eigen::AngleAxisd(0, Eigen::Vector3d::UnitZ())
+    * Eigen::AngleAxisd(0, Eigen::Vector3d::UnitY())
+    * Eigen::AngleAxisd(0, Eigen::Vector3d::UnitX())
+    * Eigen::Translation3d(0, 0, 0);
+}
+
 void PoslvControl::colorChanged(const QString& role, const QColor& color) {
   emit updateViews();
 }
@@ -179,6 +196,7 @@ void PoslvControl::showAccelerationToggled(bool checked) {
 }
 
 void PoslvControl::renderView(View& view) {
+  view.beginTiming(*this);
   if (_ui->showPathCheckBox->isChecked())
     renderPath(view, _palette.getColor("Path"));
   if (_ui->showAxesCheckBox->isChecked())
@@ -187,6 +205,7 @@ void PoslvControl::renderView(View& view) {
     renderVelocity(view, _palette.getColor("Velocity"));
   if (_ui->showAccelerationCheckBox->isChecked())
     renderAcceleration(view, _palette.getColor("Acceleration"));
+  view.endTiming();
 }
 
 void PoslvControl::messageRead(
@@ -230,22 +249,12 @@ void PoslvControl::messageRead(
   }
 }
 
-void PoslvControl::messageRead(const rosbag::MessageInstance& message) {
-  if (message.isType<poslv::VehicleNavigationSolutionMsg>()) {
-    poslv::VehicleNavigationSolutionMsgPtr vns(
-      message.instantiate<poslv::VehicleNavigationSolutionMsg>());
-    messageRead(vns);
-  }
+void PoslvControl::clearClicked() {
+  clearPath();
+  emit updateViews();
 }
 
-void PoslvControl::clearClicked() {
-  _path.clear();
-  _linearVelocity = Eigen::Vector3d::Zero();
-  _angularVelocity = Eigen::Vector3d::Zero();
-  _acceleration = Eigen::Vector3d::Zero();
-  _T_w_i = Eigen::AngleAxisd(0, Eigen::Vector3d::UnitZ())
-    * Eigen::AngleAxisd(0, Eigen::Vector3d::UnitY())
-    * Eigen::AngleAxisd(0, Eigen::Vector3d::UnitX())
-    * Eigen::Translation3d(0, 0, 0);
+void PoslvControl::seeked() {
+  clearPath();
   emit updateViews();
 }
@@ -25,8 +25,6 @@
 
 #include <eigen3/Eigen/Geometry>
 
-#include <rosbag/message_instance.h>
-
 #include <poslv/VehicleNavigationSolutionMsg.h>
 
 #include "gui/palette.h"
@@ -101,6 +99,8 @@ protected:
   void renderVelocity(View& view, const QColor& color);
   /// Render the current acceleration
   void renderAcceleration(View& view, const QColor& color);
+  /// Clears the path and the current motion
+  void clearPath();
   /** @}
     */
 
@@ -140,12 +140,12 @@ protected slots:
   void showAccelerationToggled(bool checked);
   /// Render the current view
   void renderView(View& view);
-  /// New message read from the bag file
-  void messageRead(const rosbag::MessageInstance& message);
   /// POS LV message received
   void messageRead(const poslv::VehicleNavigationSolutionMsgConstPtr& msg);
   /// Clear path clicked
   void clearClicked();
+  /// Message stream seeked
+  void seeked();
   /** @}
     */
 
@@ -18,23 +18,28 @@
 
 #include "gui/VelodyneControl.h"
 
+#include <algorithm>
+
 #include <QtGui/QFileDialog>
 #include <QtGui/QMessageBox>
 
 #include <libvelodyne/sensor/Calibration.h>
-#include <libvelodyne/sensor/DataPacket.h>
 #include <libvelodyne/sensor/Converter.h>
-#include <libvelodyne/data-structures/VdynePointCloud.h>
 #include <libvelodyne/exceptions/IOException.h>
 
-#include <libsnappy/snappy.h>
-
-#include "gui/BagControl.h"
+#include "gui/VelodyneConverter.h"
+#include "gui/MessageDispatcher.h"
 #include "gui/PoslvControl.h"
 #include "gui/RosControl.h"
 
 #include "ui_VelodyneControl.h"
 
+/******************************************************************************/
+/* Statics                                                                    */
+/******************************************************************************/
+
+const double VelodyneControl::_maxIntensity = 255.0;
+
 /******************************************************************************/
 /* Constructors and Destructor                                                */
 /******************************************************************************/
@@ -44,6 +49,9 @@ VelodyneControl::VelodyneControl(const Eigen::Affine3d& T_i_v, bool showPoints,
     _ui(new Ui_VelodyneControl()),
     _minRange(Converter::mMinDistance),
     _maxRange(Converter::mMaxDistance),
+    _revolutions(1),
+    _revolutionIdx(0),
+    _revolutionCount(0),
     _lastStartAngle(0),
     _revolutionPacketCounter(0),
     _T_w_i(Eigen::Translation3d(0, 0, 0)
@@ -56,8 +64,17 @@ VelodyneControl::VelodyneControl(const Eigen::Affine3d& T_i_v, bool showPoints,
   connect(&_palette, SIGNAL(colorChanged(const QString&, const QColor&)),
     this, SLOT(colorChanged(const QString&, const QColor&)));
   connect<View>(SIGNAL(render(View&)), SLOT(renderView(View&)));
-  connect<BagControl>(SIGNAL(messageRead(const rosbag::MessageInstance&)),
-    SLOT(messageRead(const rosbag::MessageInstance&)));
+  MessageDispatcher::getInstance().registerReceiver<
+    velodyne::BinarySnappyMsg>(this,
+    [this](const velodyne::BinarySnappyMsgConstPtr& msg) {
+      this->messageRead(msg);
+    });
+  connect(&MessageDispatcher::getInstance(), SIGNAL(seeked()),
+    this, SLOT(seeked()));
+  _decoder.setHandler(
+    [this](VelodyneDecoder::Packet& packet, const Eigen::Affine3d& T_w_i) {
+      this->packetDecoded(packet, T_w_i);
+    });
   connect<RosControl>(
     SIGNAL(messageRead(const velodyne::BinarySnappyMsgConstPtr&)),
     SLOT(messageRead(const velodyne::BinarySnappyMsgConstPtr&)));
@@ -67,13 +84,22 @@ VelodyneControl::VelodyneControl(const Eigen::Affine3d& T_i_v, bool showPoints,
   setPointSize(1.0);
   setShowPoints(showPoints);
   setSmoothPoints(true);
+  setIntensityColor(Qt::white);
+  setColorByIntensity(false);
   setCalibrationFilename("/etc/libvelodyne/calib-HDL-64E.dat");
   setRangeSupport(_ui->minRangeSpinBox->value(), _ui->maxRangeSpinBox->value());
   setAxesColor(Qt::yellow);
   setShowAxes(showAxes);
+  setNumRevolutions(_ui->revolutionSpinBox->value());
+  setMapBudget(_ui->mapBudgetSpinBox->value());
+  setShowMap(false);
+  setVoxelSize(_ui->voxelSizeSpinBox->value());
+  setVoxelPolicy(keepFirst);
+  setVoxelFilter(false);
 }
 
 VelodyneControl::~VelodyneControl() {
+  MessageDispatcher::getInstance().unregisterReceivers(this);
   delete _ui;
 }
 
@@ -92,6 +118,11 @@ void VelodyneControl::setPointSize(double pointSize) {
 
 void VelodyneControl::setShowPoints(bool showPoints) {
   _ui->showPointsCheckBox->setChecked(showPoints);
+  MessageDispatcher::getInstance().setReceiversEnabled(this, showPoints);
+  // Packets are no longer read while the points are hidden, the revolutions
+  // and the map would be stale once they are shown again
+  if (!showPoints)
+    clearPoints();
   emit updateViews();
 }
 
@@ -100,6 +131,15 @@ void VelodyneControl::setSmoothPoints(bool smoothPoints) {
   emit updateViews();
 }
 
+void VelodyneControl::setIntensityColor(const QColor& color) {
+  _palette.setColor("Intensity", color);
+}
+
+void VelodyneControl::setColorByIntensity(bool colorByIntensity) {
+  _ui->colorByIntensityCheckBox->setChecked(colorByIntensity);
+  emit updateViews();
+}
+
 void VelodyneControl::setCalibrationFilename(const QString& filename) {
   _ui->calibrationEdit->setText(filename);
   QFileInfo fileInfo(filename);
@@ -108,6 +148,7 @@ void VelodyneControl::setCalibrationFilename(const QString& filename) {
     _calibration.reset(new Calibration());
     try {
       calibFile >> *_calibration;
+      _converter.reset(new VelodyneConverter(*_calibration));
     }
     catch (const IOException& e) {
       QMessageBox::information(this, "VelodyneControl",
@@ -144,6 +185,7 @@ void VelodyneControl::setTransformation(double tx, double ty, double tz,
     * Eigen::AngleAxisd(rz, Eigen::Vector3d::UnitZ())
     * Eigen::AngleAxisd(ry, Eigen::Vector3d::UnitY())
     * Eigen::AngleAxisd(rx, Eigen::Vector3d::UnitX());
+  registerVoxels();
    emit updateViews();
 }
 
@@ -151,6 +193,34 @@ void VelodyneControl::setRenderingRate(size_t rate) {
   _ui->revolutionSpinBox->setValue(rate);
 }
 
+void VelodyneControl::setShowMap(bool showMap) {
+  _ui->showMapCheckBox->setChecked(showMap);
+  if (!showMap)
+    _map.clear();
+  emit updateViews();
+}
+
+void VelodyneControl::setMapBudget(double mapBudget) {
+  _ui->mapBudgetSpinBox->setValue(mapBudget);
+  _map.setMaxNumPoints(mapBudget * 1e6);
+  emit updateViews();
+}
+
+void VelodyneControl::setVoxelFilter(bool voxelFilter) {
+  _ui->voxelFilterCheckBox->setChecked(voxelFilter);
+  registerVoxels();
+}
+
+void VelodyneControl::setVoxelSize(double voxelSize) {
+  _ui->voxelSizeSpinBox->setValue(voxelSize);
+  _voxels.setVoxelSize(voxelSize);
+  registerVoxels();
+}
+
+void VelodyneControl::setVoxelPolicy(VoxelPolicy voxelPolicy) {
+  _ui->voxelPolicyComboBox->setCurrentIndex(voxelPolicy);
+}
+
 /******************************************************************************/
 /* Methods                                                                    */
 /******************************************************************************/
@@ -175,10 +245,197 @@ void VelodyneControl::renderAxes(View& view, const QColor& color,
   view.render("velodyne", labelPosition, color, 0.2 * length);
 }
 
+void VelodyneControl::setNumRevolutions(size_t numRevolutions) {
+  std::vector<Revolution> revolutions(numRevolutions + 1);
+  for (size_t i = 0; i < std::min(revolutions.size(), _revolutions.size());
+      ++i)
+    revolutions[numRevolutions - i].swap(_revolutions[(_revolutionIdx +
+      _revolutions.size() - i) % _revolutions.size()]);
+  _revolutions.swap(revolutions);
+  _revolutionIdx = numRevolutions;
+  registerVoxels();
+  emit updateViews();
+}
+
 void VelodyneControl::renderPoints(View& view, const QColor& color, double size,
     bool smooth) {
-  for (auto it = _pointCloudsDisp.cbegin(); it != _pointCloudsDisp.cend(); ++it)
-    view.render(it->first, color, size, smooth, it->second * _T_i_v);
+  for (size_t i = 0; i < _revolutions.size(); ++i)
+    if (i != _revolutionIdx || _ui->voxelFilterCheckBox->isChecked())
+      for (auto it = _revolutions[i].cbegin(); it != _revolutions[i].cend();
+          ++it) {
+        const Eigen::Affine3d T_w_v = it->T_w_i * _T_i_v;
+        if (view.isCulled(it->bounds, T_w_v))
+          continue;
+        if (_ui->colorByIntensityCheckBox->isChecked())
+          view.render(it->points, color, _palette.getColor("Intensity"),
+            _maxIntensity, size, smooth, T_w_v);
+        else
+          view.render(it->points, color, size, smooth, T_w_v);
+      }
+  if (_ui->showMapCheckBox->isChecked() && _map.getRoot())
+    renderMap(view, *_map.getRoot(), color, size, smooth);
+}
+
+void VelodyneControl::filterPoints(const PointCloud<float>& points, const
+    Eigen::Affine3d& T_w_v, PointCloud<float>& filteredPoints) {
+  const VoxelPolicy policy =
+    (VoxelPolicy)_ui->voxelPolicyComboBox->currentIndex();
+  const size_t chunkIdx = _revolutions[_revolutionIdx].size();
+  const Eigen::Affine3f T_v_w =
+    T_w_v.inverse(Eigen::Isometry).cast<float>();
+  const float* intensities = points.getIntensities();
+  for (size_t i = 0; i < points.getNumPoints(); ++i) {
+    const Eigen::Vector3f p_w =
+      (T_w_v * points.getPoint(i).cast<double>()).cast<float>();
+    const VoxelGrid<Voxel>::Key key = _voxels.getKey(p_w);
+    Voxel* voxel = _voxels.getVoxel(key);
+    if (voxel && voxel->cloudId != filteredPoints.getId() &&
+        (voxel->revolution >= _revolutions.size() ||
+        voxel->chunk >= _revolutions[voxel->revolution].size() ||
+        _revolutions[voxel->revolution][voxel->chunk].points.getId() !=
+        voxel->cloudId))
+      voxel = 0;
+    if (!voxel) {
+      Voxel newVoxel = {_revolutionIdx, chunkIdx,
+        filteredPoints.getNumPoints(), filteredPoints.getId(), 1, p_w,
+        intensities[i], _revolutionCount};
+      _voxels.setVoxel(key, newVoxel);
+      filteredPoints.addPoint(points.getPoint(i), intensities[i]);
+      continue;
+    }
+    voxel->lastSeen = _revolutionCount;
+    if (policy == keepFirst)
+      continue;
+    ++voxel->numPoints;
+    if (policy == keepCentroid) {
+      voxel->position += (p_w - voxel->position) / voxel->numPoints;
+      voxel->intensity += (intensities[i] - voxel->intensity) /
+        voxel->numPoints;
+    }
+    else if (intensities[i] > voxel->intensity) {
+      voxel->position = p_w;
+      voxel->intensity = intensities[i];
+    }
+    else
+      continue;
+    if (voxel->cloudId == filteredPoints.getId()) {
+      filteredPoints.getPoint(voxel->point) = T_v_w * voxel->position;
+      filteredPoints.getIntensities()[voxel->point] = voxel->intensity;
+    }
+  }
+}
+
+void VelodyneControl::registerVoxels() {
+  _voxels.clear();
+  if (!_ui->voxelFilterCheckBox->isChecked())
+    return;
+  for (size_t i = 0; i < _revolutions.size(); ++i)
+    for (size_t j = 0; j < _revolutions[i].size(); ++j) {
+      const Chunk& chunk = _revolutions[i][j];
+      const Eigen::Affine3d T_w_v = chunk.T_w_i * _T_i_v;
+      const float* intensities = chunk.points.getIntensities();
+      for (size_t k = 0; k < chunk.points.getNumPoints(); ++k) {
+        const Eigen::Vector3f p_w =
+          (T_w_v * chunk.points.getPoint(k).cast<double>()).cast<float>();
+        const VoxelGrid<Voxel>::Key key = _voxels.getKey(p_w);
+        if (!_voxels.getVoxel(key)) {
+          Voxel voxel = {i, j, k, chunk.points.getId(), 1, p_w,
+            intensities ? intensities[k] : 0.0f, _revolutionCount};
+          _voxels.setVoxel(key, voxel);
+        }
+      }
+    }
+}
+
+void VelodyneControl::recycleVoxels(size_t revolution) {
+  Chunk survivors;
+  survivors.points = PointCloud<float>(PointCloud<float>::Intensities);
+  survivors.T_w_i = _T_i_v.inverse(Eigen::Isometry);
+  for (size_t j = 0; j < _revolutions[revolution].size(); ++j) {
+    const Chunk& chunk = _revolutions[revolution][j];
+    const Eigen::Affine3d T_w_v = chunk.T_w_i * _T_i_v;
+    for (size_t k = 0; k < chunk.points.getNumPoints(); ++k) {
+      const VoxelGrid<Voxel>::Key key = _voxels.getKey(
+        (T_w_v * chunk.points.getPoint(k).cast<double>()).cast<float>());
+      Voxel* voxel = _voxels.getVoxel(key);
+      if (!voxel || voxel->cloudId != chunk.points.getId() ||
+          voxel->point != k)
+        continue;
+      if (voxel->lastSeen + _revolutions.size() > _revolutionCount) {
+        voxel->revolution = revolution;
+        voxel->chunk = 0;
+        voxel->point = survivors.points.getNumPoints();
+        voxel->cloudId = survivors.points.getId();
+        survivors.points.addPoint(voxel->position, voxel->intensity);
+      }
+      else
+        _voxels.removeVoxel(key);
+    }
+  }
+  _revolutions[revolution].clear();
+  if (!survivors.points.isEmpty()) {
+    survivors.bounds = survivors.points.getBounds().cast<double>();
+    _revolutions[revolution].push_back(std::move(survivors));
+  }
+}
+
+void VelodyneControl::clearPoints() {
+  _decoder.clear();
+  _map.clear();
+  _voxels.clear();
+  for (auto it = _revolutions.begin(); it != _revolutions.end(); ++it)
+    it->clear();
+  _lastStartAngle = 0;
+  _revolutionPacketCounter = 0;
+}
+
+void VelodyneControl::packetDecoded(VelodyneDecoder::Packet& packet,
+    const Eigen::Affine3d& T_w_i) {
+  if ((_lastStartAngle > packet.endAngle ||
+      packet.startAngle > packet.endAngle) && _revolutionPacketCounter) {
+    _revolutionPacketCounter = 0;
+    _revolutionIdx = (_revolutionIdx + 1) % _revolutions.size();
+    ++_revolutionCount;
+    if (_voxels.getNumVoxels())
+      recycleVoxels(_revolutionIdx);
+    else
+      _revolutions[_revolutionIdx].clear();
+    emit updateViews();
+  }
+  else {
+    _revolutionPacketCounter++;
+  }
+  _lastStartAngle = packet.startAngle;
+  if (_ui->showMapCheckBox->isChecked())
+    _map.insert(*packet.points, (T_w_i * _T_i_v).cast<float>());
+  Chunk chunk;
+  if (_ui->voxelFilterCheckBox->isChecked()) {
+    chunk.points = PointCloud<float>(PointCloud<float>::Intensities);
+    chunk.points.reserve(packet.points->getNumPoints());
+    filterPoints(*packet.points, T_w_i * _T_i_v, chunk.points);
+    chunk.bounds = chunk.points.getBounds().cast<double>();
+  }
+  else {
+    chunk.points = std::move(*packet.points);
+    chunk.bounds = packet.bounds.cast<double>();
+  }
+  chunk.T_w_i = T_w_i;
+  _revolutions[_revolutionIdx].push_back(std::move(chunk));
+}
+
+void VelodyneControl::renderMap(View& view, const PointOctree<float>::Node&
+    node, const QColor& color, double size, bool smooth) {
+  const Eigen::AlignedBox<double, 3> bounds = node.getBounds().cast<double>();
+  const View::Transformation T = View::Transformation::Identity();
+  if (view.isCulled(bounds, T))
+    return;
+  view.render(node.getPoints(), color, size, smooth);
+  if (view.getProjectedSize(bounds, T) / PointOctree<float>::gridSize <
+      std::max(size, 1.0))
+    return;
+  for (size_t i = 0; i < 8; ++i)
+    if (node.getChild(i))
+      renderMap(view, *node.getChild(i), color, size, smooth);
 }
 
 void VelodyneControl::calibrationBrowseClicked() {
@@ -205,83 +462,46 @@ void VelodyneControl::smoothPointsToggled(bool checked) {
   setSmoothPoints(checked);
 }
 
+void VelodyneControl::colorByIntensityToggled(bool checked) {
+  setColorByIntensity(checked);
+}
+
 void VelodyneControl::rangeSupportChanged() {
   setRangeSupport(_ui->minRangeSpinBox->value(), _ui->maxRangeSpinBox->value());
 }
 
 void VelodyneControl::renderView(View& view) {
+  view.beginTiming(*this);
   if (_ui->showPointsCheckBox->isChecked())
     renderPoints(view, _palette.getColor("Point"),
       _ui->pointSizeSpinBox->value(),
       _ui->smoothPointsCheckBox->isChecked());
   if (_ui->showAxesCheckBox->isChecked())
     renderAxes(view, _palette.getColor("Axes"), 0.5);
+  view.endTiming();
 }
 
 
 void VelodyneControl::messageRead(
     const velodyne::BinarySnappyMsgConstPtr& msg) {
-  std::string uncompressedData;
-  snappy::Uncompress(
-    reinterpret_cast<const char*>(msg->data.data()),
-    msg->data.size(), &uncompressedData);
-  DataPacket dataPacket;
-  std::istringstream binaryStream(uncompressedData);
-  dataPacket.readBinary(binaryStream);
-  VdynePointCloud pointCloud;
-  Converter::toPointCloud(dataPacket, *_calibration, pointCloud, _minRange,
-    _maxRange);
-  const double startAngle = Calibration::deg2rad(
-    dataPacket.getDataChunk(0).mRotationalInfo /
-    (double)DataPacket::mRotationResolution);
-  const double endAngle = Calibration::deg2rad(
-    dataPacket.getDataChunk(DataPacket::mDataChunkNbr - 1).mRotationalInfo /
-    (double)DataPacket::mRotationResolution);
-  if ((_lastStartAngle > endAngle || startAngle > endAngle) &&
-      _revolutionPacketCounter) {
-    _revolutionPacketCounter = 0;
-    static size_t turnDispCount = 0;
-    turnDispCount++;
-    if (turnDispCount >= _ui->revolutionSpinBox->value()) {
-      turnDispCount = 0;
-      _pointCloudsDisp.clear();
-    }
-    _pointCloudsDisp.reserve(_pointCloudsDisp.size() + _pointCloudsAcq.size());
-    for (auto it = _pointCloudsAcq.cbegin(); it != _pointCloudsAcq.cend();
-        ++it)
-       _pointCloudsDisp.push_back(*it);
-    _pointCloudsAcq.clear();
-    emit updateViews();
-  }
-  else {
-    _revolutionPacketCounter++;
-  }
-  _lastStartAngle = startAngle;
-  Points<double, 3> points;
-  _pointCloudsAcq.push_back(std::make_pair(points, _T_w_i));
-  _pointCloudsAcq.back().first.setNumPoints(pointCloud.getSize());
-  size_t i = 0;
-  for (auto it = pointCloud.getPointBegin(); it != pointCloud.getPointEnd();
-      ++it) {
-    Points<double, 3>::Point point(it->mX, it->mY, it->mZ);
-    _pointCloudsAcq.back().first[i++] = point;
-  }
+  if (_converter)
+    _decoder.push(msg, _converter, _minRange, _maxRange, _T_w_i);
 }
 
-void VelodyneControl::messageRead(const rosbag::MessageInstance& message) {
-  if (message.isType<velodyne::BinarySnappyMsg>()) {
-    velodyne::BinarySnappyMsgPtr binarySnappyMsg(
-      message.instantiate<velodyne::BinarySnappyMsg>());
-    messageRead(binarySnappyMsg);
-  }
+void VelodyneControl::clearClicked() {
+  clearPoints();
+  emit updateViews();
 }
 
-void VelodyneControl::clearClicked() {
-  _pointCloudsAcq.clear();
-  _pointCloudsDisp.clear();
+void VelodyneControl::seeked() {
+  clearPoints();
   emit updateViews();
 }
 
+void VelodyneControl::revolutionsChanged(int numRevolutions) {
+  setNumRevolutions(numRevolutions);
+}
+
 void VelodyneControl::showAxesToggled(bool checked) {
   setShowAxes(checked);
 }
@@ -295,3 +515,23 @@ void VelodyneControl::transformationChanged() {
 void VelodyneControl::poseUpdate(const Eigen::Affine3d& T_w_i) {
   _T_w_i = T_w_i;
 }
+
+void VelodyneControl::showMapToggled(bool checked) {
+  setShowMap(checked);
+}
+
+void VelodyneControl::mapBudgetChanged(double mapBudget) {
+  setMapBudget(mapBudget);
+}
+
+void VelodyneControl::voxelFilterToggled(bool checked) {
+  setVoxelFilter(checked);
+}
+
+void VelodyneControl::voxelSizeChanged(double voxelSize) {
+  setVoxelSize(voxelSize);
+}
+
+void VelodyneControl::voxelPolicyChanged(int index) {
+  setVoxelPolicy((VoxelPolicy)index);
+}
@@ -25,16 +25,19 @@
 
 #include <memory>
 
-#include <rosbag/message_instance.h>
-
 #include <velodyne/BinarySnappyMsg.h>
 
 #include "gui/palette.h"
 #include "gui/view.h"
 #include "gui/control.h"
+#include "gui/VelodyneDecoder.h"
+
+#include "utils/PointOctree.h"
+#include "utils/VoxelGrid.h"
 
 class Ui_VelodyneControl;
 class Calibration;
+class VelodyneConverter;
 
 /** The VelodyneControl class represents a Qt control for displaying
     Velodyne HDL data.
@@ -54,6 +57,21 @@ Q_OBJECT
     */
 
 public:
+  /** \name Types definitions
+    @{
+    */
+  /// Point kept in a voxel by the voxel filter
+  enum VoxelPolicy {
+    /// First point falling into the voxel
+    keepFirst = 0,
+    /// Centroid of the points falling into the voxel
+    keepCentroid = 1,
+    /// Point with the maximum intensity
+    keepMaxIntensity = 2
+  };
+  /** @}
+    */
+
   /** \name Constructors/destructor
     @{
     */
@@ -76,6 +94,10 @@ public:
   void setShowPoints(bool showPoints);
   /// Smoothes the points
   void setSmoothPoints(bool smoothPoints);
+  /// Sets the point color of the maximum intensity
+  void setIntensityColor(const QColor& color);
+  /// Colors the points by intensity
+  void setColorByIntensity(bool colorByIntensity);
   /// Sets the calibration file name
   void setCalibrationFilename(const QString& filename);
   /// Sets the range support
@@ -89,15 +111,80 @@ public:
     double rx);
   /// Sets the rendering rate
   void setRenderingRate(size_t rate);
+  /// Accumulates and shows the map
+  void setShowMap(bool showMap);
+  /// Sets the point budget of the map in millions of points
+  void setMapBudget(double mapBudget);
+  /// Enables the voxel filter for accumulated points
+  void setVoxelFilter(bool voxelFilter);
+  /// Sets the voxel size of the voxel filter
+  void setVoxelSize(double voxelSize);
+  /// Sets the point kept in a voxel by the voxel filter
+  void setVoxelPolicy(VoxelPolicy voxelPolicy);
   /** @}
     */
 
 protected:
+  /** \name Protected types
+    @{
+    */
+  /// Points of one packet with their bounds and acquisition pose
+  struct Chunk {
+    /// Points in the sensor frame
+    PointCloud<float> points;
+    /// Bounding box of the points in the sensor frame
+    Eigen::AlignedBox<double, 3> bounds;
+    /// Transformation from IMU to world at acquisition
+    Eigen::Affine3d T_w_i;
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+  /// Packets of one revolution
+  typedef std::vector<Chunk, Eigen::aligned_allocator<Chunk> > Revolution;
+  /// Location of the point kept in a voxel
+  struct Voxel {
+    /// Revolution index of the chunk
+    size_t revolution;
+    /// Index of the chunk in its revolution
+    size_t chunk;
+    /// Index of the point in its chunk
+    size_t point;
+    /// Identifier of the chunk cloud, to detect stale voxels
+    size_t cloudId;
+    /// Number of points merged into the voxel
+    size_t numPoints;
+    /// Merged point in the world frame
+    Eigen::Vector3f position;
+    /// Merged intensity
+    float intensity;
+    /// Revolution counter when a point last fell into the voxel
+    size_t lastSeen;
+  };
+  /** @}
+    */
+
   /** \name Protected methods
     @{
     */
+  /// Sets the number of revolutions displayed, keeping the latest ones
+  void setNumRevolutions(size_t numRevolutions);
   /// Render the current points
   void renderPoints(View& view, const QColor& color, double size, bool smooth);
+  /// Filters the points of a packet against the voxels of stored points
+  void filterPoints(const PointCloud<float>& points, const Eigen::Affine3d&
+    T_w_v, PointCloud<float>& filteredPoints);
+  /// Registers the points of the stored revolutions with the voxel filter
+  void registerVoxels();
+  /// Moves the voxels of a recycled revolution that were seen in the
+  /// displayed revolutions into a chunk of that revolution, drops the others
+  void recycleVoxels(size_t revolution);
+  /// Drops the decoded revolutions, the voxels and the map
+  void clearPoints();
+  /// Stores a decoded packet, taking ownership of its points
+  void packetDecoded(VelodyneDecoder::Packet& packet,
+    const Eigen::Affine3d& T_w_i);
+  /// Render a map node and its children down to the screen resolution
+  void renderMap(View& view, const PointOctree<float>::Node& node,
+    const QColor& color, double size, bool smooth);
   /// Render the current axes
   void renderAxes(View& view, const QColor& color, double length);
   /** @}
@@ -112,14 +199,18 @@ protected:
   Palette _palette;
   /// Velodyne calibration
   std::shared_ptr<Calibration> _calibration;
+  /// Velodyne converter tabulated from the calibration
+  std::shared_ptr<const VelodyneConverter> _converter;
   /// Min range
   double _minRange;
   /// Max range
   double _maxRange;
-  /// Point cloud displaying
-  std::vector<std::pair<Points<double, 3>, Eigen::Affine3d> > _pointCloudsDisp;
-  /// Point cloud acquiring
-  std::vector<std::pair<Points<double, 3>, Eigen::Affine3d> > _pointCloudsAcq;
+  /// Ring of revolutions, all displayed but the one being acquired
+  std::vector<Revolution> _revolutions;
+  /// Index of the revolution being acquired
+  size_t _revolutionIdx;
+  /// Number of revolutions acquired so far
+  size_t _revolutionCount;
   /// Last start angle
   double _lastStartAngle;
   /// Packet counter for one sensor revolution
@@ -128,6 +219,14 @@ protected:
   Eigen::Affine3d _T_w_i;
   /// Transformation from Velodyne to IMU
   Eigen::Affine3d _T_i_v;
+  /// Parallel packet decoder
+  VelodyneDecoder _decoder;
+  /// Level-of-detail map accumulated in the world frame
+  PointOctree<float> _map;
+  /// Voxels of the stored points in the world frame
+  VoxelGrid<Voxel> _voxels;
+  /// Maximum intensity returned by the sensor
+  static const double _maxIntensity;
   /** @}
     */
 
@@ -149,18 +248,32 @@ protected slots:
   void rangeSupportChanged();
   /// Render the current view  
   void renderView(View& view);
-  /// New message read from the bag file
-  void messageRead(const rosbag::MessageInstance& message);
   /// Velodyne message received
   void messageRead(const velodyne::BinarySnappyMsgConstPtr& msg);
   /// Pose update
   void poseUpdate(const Eigen::Affine3d& T_w_i);
   /// Clear points clicked
   void clearClicked();
+  /// Number of revolutions displayed changed
+  void revolutionsChanged(int numRevolutions);
+  /// Message stream seeked
+  void seeked();
   /// Show axes toggled
   void showAxesToggled(bool checked);
   /// Transformation changed
   void transformationChanged();
+  /// Show map toggled
+  void showMapToggled(bool checked);
+  /// Map budget changed
+  void mapBudgetChanged(double mapBudget);
+  /// Voxel filter toggled
+  void voxelFilterToggled(bool checked);
+  /// Voxel size changed
+  void voxelSizeChanged(double voxelSize);
+  /// Voxel policy changed
+  void voxelPolicyChanged(int index);
+  /// Color by intensity toggled
+  void colorByIntensityToggled(bool checked);
   /** @}
     */
 
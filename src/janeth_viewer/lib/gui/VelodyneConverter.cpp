@@ -0,0 +1,92 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include "gui/VelodyneConverter.h"
+
+#include <cmath>
+
+#include <libvelodyne/sensor/Calibration.h>
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+VelodyneConverter::VelodyneConverter(const Calibration& calibration) :
+    _cosRot(360 * DataPacket::mRotationResolution),
+    _sinRot(360 * DataPacket::mRotationResolution) {
+  for (size_t i = 0; i < 2; ++i)
+    for (size_t j = 0; j < DataPacket::DataChunk::mLasersPerPacket; ++j) {
+      const size_t laserIdx = i * DataPacket::DataChunk::mLasersPerPacket + j;
+      const double rotCorr = calibration.getRotCorr(laserIdx);
+      const double vertCorr = calibration.getVertCorr(laserIdx);
+      const double vertOffsCorr = calibration.getVertOffsCorr(laserIdx);
+      _banks[i].distCorr[j] = calibration.getDistCorr(laserIdx);
+      _banks[i].cosRotCorr[j] = cos(rotCorr);
+      _banks[i].sinRotCorr[j] = sin(rotCorr);
+      _banks[i].cosVertCorr[j] = cos(vertCorr);
+      _banks[i].sinVertCorr[j] = sin(vertCorr);
+      _banks[i].vertOffsCosVertCorr[j] = vertOffsCorr * cos(vertCorr);
+      _banks[i].vertOffsSinVertCorr[j] = vertOffsCorr * sin(vertCorr);
+      _banks[i].horizOffsCorr[j] = calibration.getHorizOffsCorr(laserIdx);
+    }
+  for (size_t i = 0; i < _cosRot.size(); ++i) {
+    const double rotation = Calibration::deg2rad(i /
+      (double)DataPacket::mRotationResolution);
+    _cosRot[i] = cos(rotation);
+    _sinRot[i] = sin(rotation);
+  }
+}
+
+VelodyneConverter::~VelodyneConverter() {
+}
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+void VelodyneConverter::toPointCloud(const DataPacket& dataPacket,
+    PointCloud<float>& pointCloud, double minRange, double maxRange) const {
+  const float distanceScale = 1.0 / DataPacket::mDistanceResolution;
+  for (size_t i = 0; i < DataPacket::mDataChunkNbr; ++i) {
+    const DataPacket::DataChunk& data = dataPacket.getDataChunk(i);
+    const Bank& bank = _banks[data.mHeaderInfo == DataPacket::mLowerBank];
+    const size_t rotation = data.mRotationalInfo % _cosRot.size();
+    const float cosRot = _cosRot[rotation];
+    const float sinRot = _sinRot[rotation];
+    LaserArray rawDistance;
+    for (size_t j = 0; j < DataPacket::DataChunk::mLasersPerPacket; ++j)
+      rawDistance[j] = data.mLaserData[j].mDistance;
+    const LaserArray distance = rawDistance * distanceScale + bank.distCorr;
+    const LaserArray cosCorrRot = cosRot * bank.cosRotCorr +
+      sinRot * bank.sinRotCorr;
+    const LaserArray sinCorrRot = sinRot * bank.cosRotCorr -
+      cosRot * bank.sinRotCorr;
+    const LaserArray xyDistance = distance * bank.cosVertCorr -
+      bank.vertOffsSinVertCorr;
+    const LaserArray x = xyDistance * sinCorrRot -
+      bank.horizOffsCorr * cosCorrRot;
+    const LaserArray y = xyDistance * cosCorrRot +
+      bank.horizOffsCorr * sinCorrRot;
+    const LaserArray z = distance * bank.sinVertCorr +
+      bank.vertOffsCosVertCorr;
+    for (size_t j = 0; j < DataPacket::DataChunk::mLasersPerPacket; ++j)
+      if ((distance[j] >= minRange) && (distance[j] <= maxRange))
+        pointCloud.addPoint(PointCloud<float>::Point(x[j], y[j], z[j]),
+          data.mLaserData[j].mIntensity);
+  }
+}
@@ -0,0 +1,121 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file VelodyneConverter.h
+    \brief This file defines a table-driven converter for Velodyne HDL
+           packets.
+  */
+
+#ifndef VELODYNECONVERTER_H
+#define VELODYNECONVERTER_H
+
+#include <vector>
+
+#include <eigen3/Eigen/Core>
+
+#include <libvelodyne/sensor/DataPacket.h>
+
+#include "utils/PointCloud.h"
+
+class Calibration;
+
+/** The VelodyneConverter class converts Velodyne HDL packets into point
+    clouds like Converter::toPointCloud, but without evaluating any
+    trigonometric function per return. The per-laser corrections and the
+    sines and cosines of all encoder positions are tabulated once from the
+    calibration, and the 32 returns of a data chunk are converted at once
+    with vectorized Eigen arrays.
+    \brief Table-driven converter for Velodyne HDL packets.
+  */
+class VelodyneConverter {
+  /** \name Private constructors
+    @{
+    */
+  /// Copy constructor
+  VelodyneConverter(const VelodyneConverter& other);
+  /// Assignment operator
+  VelodyneConverter& operator = (const VelodyneConverter& other);
+  /** @}
+    */
+
+public:
+  /** \name Constructors/destructor
+    @{
+    */
+  /// Constructs the converter from a calibration
+  VelodyneConverter(const Calibration& calibration);
+  /// Destructor
+  ~VelodyneConverter();
+  /** @}
+    */
+
+  /** \name Methods
+    @{
+    */
+  /// Converts a packet and appends the points within a range to a cloud
+  void toPointCloud(const DataPacket& dataPacket, PointCloud<float>& pointCloud,
+    double minRange, double maxRange) const;
+  /** @}
+    */
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+protected:
+  /** \name Protected types
+    @{
+    */
+  /// Values for the lasers of one data chunk
+  typedef Eigen::Array<float, DataPacket::DataChunk::mLasersPerPacket, 1>
+    LaserArray;
+  /// Corrections for the lasers of one bank
+  struct Bank {
+    /// Distance correction
+    LaserArray distCorr;
+    /// Cosine of the rotational correction
+    LaserArray cosRotCorr;
+    /// Sine of the rotational correction
+    LaserArray sinRotCorr;
+    /// Cosine of the vertical correction
+    LaserArray cosVertCorr;
+    /// Sine of the vertical correction
+    LaserArray sinVertCorr;
+    /// Vertical offset times cosine of the vertical correction
+    LaserArray vertOffsCosVertCorr;
+    /// Vertical offset times sine of the vertical correction
+    LaserArray vertOffsSinVertCorr;
+    /// Horizontal offset
+    LaserArray horizOffsCorr;
+  };
+  /** @}
+    */
+
+  /** \name Protected members
+    @{
+    */
+  /// Corrections of the upper and lower banks
+  Bank _banks[2];
+  /// Cosine of every encoder position
+  std::vector<float> _cosRot;
+  /// Sine of every encoder position
+  std::vector<float> _sinRot;
+  /** @}
+    */
+
+};
+
+#endif // VELODYNECONVERTER_H
@@ -0,0 +1,153 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include "gui/VelodyneDecoder.h"
+
+#include <istream>
+#include <exception>
+
+#include <QtCore/QTimer>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QtConcurrentRun>
+
+#include <libvelodyne/sensor/Calibration.h>
+#include <libvelodyne/sensor/DataPacket.h>
+
+#include <libsnappy/snappy.h>
+
+#include "gui/VelodyneConverter.h"
+
+#include "utils/MemoryStreamBuffer.h"
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+VelodyneDecoder::VelodyneDecoder(size_t maxPending) :
+    _maxPending(maxPending),
+    _handoffRequested(false) {
+}
+
+VelodyneDecoder::~VelodyneDecoder() {
+  clear();
+}
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+size_t VelodyneDecoder::getNumPending() const {
+  return _jobs.size();
+}
+
+void VelodyneDecoder::setHandler(const Handler& handler) {
+  _handler = handler;
+}
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+void VelodyneDecoder::push(const velodyne::BinarySnappyMsgConstPtr& msg,
+    const std::shared_ptr<const VelodyneConverter>& converter,
+    double minRange, double maxRange, const Eigen::Affine3d& T_w_i) {
+  while (_jobs.size() >= _maxPending) {
+    _jobs.front().packet.waitForFinished();
+    handoff();
+  }
+  Job job;
+  job.packet = QtConcurrent::run(this, &VelodyneDecoder::decode, msg,
+    converter, minRange, maxRange);
+  job.T_w_i = T_w_i;
+  _jobs.push_back(job);
+}
+
+void VelodyneDecoder::clear() {
+  for (auto it = _jobs.begin(); it != _jobs.end(); ++it)
+    it->packet.waitForFinished();
+  _jobs.clear();
+}
+
+bool VelodyneDecoder::parse(const velodyne::BinarySnappyMsg& msg,
+    Buffer& buffer, DataPacket& dataPacket) {
+  const char* compressedData = reinterpret_cast<const char*>(msg.data.data());
+  size_t uncompressedSize = 0;
+  if (!snappy::GetUncompressedLength(compressedData, msg.data.size(),
+      &uncompressedSize))
+    return false;
+  buffer.resize(uncompressedSize);
+  if (!snappy::RawUncompress(compressedData, msg.data.size(), buffer.data()))
+    return false;
+  try {
+    MemoryStreamBuffer<> streamBuffer(buffer.data(), buffer.size());
+    std::istream binaryStream(&streamBuffer);
+    dataPacket.readBinary(binaryStream);
+  }
+  catch (std::exception& e) {
+    return false;
+  }
+  return true;
+}
+
+VelodyneDecoder::Packet VelodyneDecoder::decode(
+    const velodyne::BinarySnappyMsgConstPtr& msg,
+    const std::shared_ptr<const VelodyneConverter>& converter,
+    double minRange, double maxRange) {
+  static QThreadStorage<Buffer*> buffers;
+  if (!buffers.hasLocalData())
+    buffers.setLocalData(new Buffer());
+  Buffer& buffer = *buffers.localData();
+  Packet packet;
+  DataPacket dataPacket;
+  if (parse(*msg, buffer, dataPacket)) {
+    try {
+      packet.startAngle = Calibration::deg2rad(
+        dataPacket.getDataChunk(0).mRotationalInfo /
+        (double)DataPacket::mRotationResolution);
+      packet.endAngle = Calibration::deg2rad(
+        dataPacket.getDataChunk(DataPacket::mDataChunkNbr - 1).
+        mRotationalInfo / (double)DataPacket::mRotationResolution);
+      packet.points.reset(
+        new PointCloud<float>(PointCloud<float>::Intensities));
+      packet.points->reserve(DataPacket::mDataChunkNbr *
+        DataPacket::DataChunk::mLasersPerPacket);
+      converter->toPointCloud(dataPacket, *packet.points, minRange,
+        maxRange);
+      packet.bounds = packet.points->getBounds();
+    }
+    catch (std::exception& e) {
+      packet.points.reset();
+    }
+  }
+  if (!_handoffRequested.exchange(true))
+    QMetaObject::invokeMethod(this, "handoff", Qt::QueuedConnection);
+  return packet;
+}
+
+void VelodyneDecoder::handoff() {
+  _handoffRequested = false;
+  while (!_jobs.empty() && _jobs.front().packet.isFinished()) {
+    const Job job = _jobs.front();
+    _jobs.pop_front();
+    Packet packet = job.packet.result();
+    if (packet.points && _handler)
+      _handler(packet, job.T_w_i);
+  }
+  if (!_jobs.empty() && !_handoffRequested.exchange(true))
+    QTimer::singleShot(1, this, SLOT(handoff()));
+}
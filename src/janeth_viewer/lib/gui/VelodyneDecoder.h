@@ -0,0 +1,175 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file VelodyneDecoder.h
+    \brief This file defines a parallel decoder for Velodyne HDL packets.
+  */
+
+#ifndef VELODYNEDECODER_H
+#define VELODYNEDECODER_H
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <functional>
+
+#include <QtCore/QObject>
+#include <QtCore/QFuture>
+
+#include <eigen3/Eigen/Geometry>
+
+#include <velodyne/BinarySnappyMsg.h>
+
+#include "utils/PointCloud.h"
+
+class VelodyneConverter;
+class DataPacket;
+
+/** The VelodyneDecoder class decompresses and converts Velodyne HDL packets
+    into point clouds on the Qt global thread pool. Packets are decoded in
+    parallel, but handed back on the GUI thread in the order they were
+    pushed, together with the pose of the sensor at push time. The number of
+    packets in flight is bounded: pushing blocks on the oldest packet rather
+    than dropping messages. Packets that fail to decompress or to parse are
+    dropped. The handoff is requested by the workers when a packet is
+    decoded, and polled while packets are in flight. Each packet is handed
+    to a single handler, which takes ownership of its points.
+    \brief Parallel decoder for Velodyne HDL packets.
+  */
+class VelodyneDecoder :
+  public QObject {
+Q_OBJECT
+  /** \name Private constructors
+    @{
+    */
+  /// Copy constructor
+  VelodyneDecoder(const VelodyneDecoder& other);
+  /// Assignment operator
+  VelodyneDecoder& operator = (const VelodyneDecoder& other);
+  /** @}
+    */
+
+public:
+  /** \name Types definitions
+    @{
+    */
+  /// Decompression buffer, reused across packets
+  typedef std::vector<char, Eigen::aligned_allocator<char> > Buffer;
+  /// Decoded packet
+  struct Packet {
+    /// Points of the packet in the sensor frame, with intensities
+    std::shared_ptr<PointCloud<float> > points;
+    /// Bounding box of the points in the sensor frame
+    PointCloud<float>::Bounds bounds;
+    /// Rotational angle of the first data chunk in radians
+    double startAngle;
+    /// Rotational angle of the last data chunk in radians
+    double endAngle;
+  };
+  /// Handler of the decoded packets, may move the points out of the packet
+  typedef std::function<void(Packet& packet, const Eigen::Affine3d& T_w_i)>
+    Handler;
+  /** @}
+    */
+
+  /** \name Constructors/destructor
+    @{
+    */
+  /// Constructs the decoder with a bound on the packets in flight
+  VelodyneDecoder(size_t maxPending = 1024);
+  /// Destructor
+  ~VelodyneDecoder();
+  /** @}
+    */
+
+  /** \name Accessors
+    @{
+    */
+  /// Returns the number of packets in flight
+  size_t getNumPending() const;
+  /// Sets the handler of the decoded packets, called in push order
+  void setHandler(const Handler& handler);
+  /** @}
+    */
+
+  /** \name Methods
+    @{
+    */
+  /// Queues a packet for decoding
+  void push(const velodyne::BinarySnappyMsgConstPtr& msg,
+    const std::shared_ptr<const VelodyneConverter>& converter,
+    double minRange, double maxRange, const Eigen::Affine3d& T_w_i);
+  /// Waits for the packets in flight and drops them
+  void clear();
+  /// Decompresses and parses a packet in place, false if it is corrupt
+  static bool parse(const velodyne::BinarySnappyMsg& msg, Buffer& buffer,
+    DataPacket& dataPacket);
+  /** @}
+    */
+
+protected:
+  /** \name Protected types
+    @{
+    */
+  /// Packet in flight
+  struct Job {
+    /// Decoding result
+    QFuture<Packet> packet;
+    /// Transformation from IMU to world at push time
+    Eigen::Affine3d T_w_i;
+  };
+  /** @}
+    */
+
+  /** \name Protected methods
+    @{
+    */
+  /// Decodes a packet, called from the thread pool
+  Packet decode(const velodyne::BinarySnappyMsgConstPtr& msg,
+    const std::shared_ptr<const VelodyneConverter>& converter,
+    double minRange, double maxRange);
+  /** @}
+    */
+
+  /** \name Protected members
+    @{
+    */
+  /// Packets in flight, in push order
+  std::deque<Job> _jobs;
+  /// Maximum number of packets in flight
+  size_t _maxPending;
+  /// Handoff to the GUI thread already requested
+  std::atomic<bool> _handoffRequested;
+  /// Handler of the decoded packets
+  Handler _handler;
+  /** @}
+    */
+
+protected slots:
+  /** \name Qt slots
+    @{
+    */
+  /// Hands the decoded packets back in order
+  void handoff();
+  /** @}
+    */
+
+};
+
+#endif // VELODYNEDECODER_H
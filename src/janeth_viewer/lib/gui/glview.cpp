@@ -18,10 +18,15 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
 #include <QtCore/QFileInfo>
 #include <QtCore/QDir>
 
 #include <QtGui/QFileDialog>
+#include <QtGui/QFontMetrics>
 
 #include <FTGL/ftgl.h>
 
@@ -29,6 +34,20 @@
 
 #include "ui_glview.h"
 
+/*****************************************************************************/
+/* Statics                                                                   */
+/*****************************************************************************/
+
+const size_t GLView::maxNumTextLists = 256;
+const size_t GLView::maxBufferMemory = 128*1024*1024;
+const size_t GLView::maxBufferAge = 100;
+const double GLView::sizeBinWidth = 0.5;
+const size_t GLView::maxNumSizeBins = 32;
+
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+
 /*****************************************************************************/
 /* Constructors and Destructor                                               */
 /*****************************************************************************/
@@ -36,7 +55,17 @@
 GLView::GLView() :
   ui(new Ui_GLView()),
   quadric(0),
-  font(0) {
+  font(0),
+  frame(0),
+  textListUses(0),
+  timerQueriesResolved(false),
+  genQueries(0),
+  deleteQueries(0),
+  beginQuery(0),
+  endQuery(0),
+  getQueryObjectiv(0),
+  getQueryObjectui64v(0),
+  timerQueryActive(false) {
   ui->setupUi(this);
 
   menu.addAction("Set Font...", this, SLOT(fontBrowseClicked()));
@@ -66,6 +95,12 @@ GLView::GLView() :
 }
 
 GLView::~GLView() {
+  ui->display->makeCurrent();
+  cloudBuffers.clear();
+  clearTextures();
+  clearTextLists();
+  clearTimerQueries();
+
   if (font)
     delete font;
 
@@ -90,6 +125,8 @@ void GLView::setFont(const QString& filename) {
       delete font;
       font = 0;
     }
+    ui->display->makeCurrent();
+    clearTextLists();
     this->fontFilename = filename;
 
     emit fontChanged(fontFilename);
@@ -114,30 +151,6 @@ GLView::Viewport GLView::getViewport() const {
   return viewport;
 }
 
-void GLView::setProjection(const Projection& projection) {
-  glMatrixMode(GL_PROJECTION);
-  glLoadMatrixd(projection.data());
-}
-
-GLView::Projection GLView::getProjection() const {
-  Projection projection;
-  glGetDoublev(GL_PROJECTION_MATRIX, projection.data());
-
-  return projection;
-}
-
-void GLView::setTransformation(const Transformation& transformation) {
-  glMatrixMode(GL_MODELVIEW);
-  glLoadMatrixd(transformation.data());
-}
-
-GLView::Transformation GLView::getTransformation() const {
-  Transformation transformation;
-  glGetDoublev(GL_MODELVIEW_MATRIX, transformation.data());
-
-  return transformation;
-}
-
 void GLView::setDumpDirectory(const QString& dirname) {
   QDir dir(dirname);
   ui->dumpDirEdit->setText(dir.absolutePath());
@@ -165,33 +178,6 @@ void GLView::setDumpAll(bool dumpAll) {
 /* Methods                                                                   */
 /*****************************************************************************/
 
-void GLView::saveTransformation() {
-  glPushMatrix();
-}
-
-void GLView::restoreTransformation() {
-  glPopMatrix();
-}
-
-void GLView::transform(const Transformation& transformation) {
-  glMatrixMode(GL_MODELVIEW);
-  glMultMatrixd(transformation.data());
-}
-
-void GLView::translate(const Translation& translation) {
-  glTranslated(translation[0], translation[1], translation[2]);
-}
-
-void GLView::rotate(const Rotation& rotation) {
-  glRotated(rotation[2]*180.0/M_PI, 1, 0, 0);
-  glRotated(rotation[1]*180.0/M_PI, 0, 1, 0);
-  glRotated(rotation[0]*180.0/M_PI, 0, 0, 1);
-}
-
-void GLView::scale(const Scale& scale) {
-  glScaled(scale[0], scale[1], scale[2]);
-}
-
 void GLView::clear(const QColor& color) {
   glClearColor(color.redF(), color.greenF(), color.blueF(), 0.0);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -214,6 +200,9 @@ void GLView::enableFog(const QColor& color, double start, double end,
 
 void GLView::render(const Points<double, 3>& vertices, const QColor& color,
     double size, bool smooth) {
+  if (!vertices.getNumPoints())
+    return;
+  loadTransformation();
   if (size > 1.0)
     glPointSize(size);
   else
@@ -224,10 +213,11 @@ void GLView::render(const Points<double, 3>& vertices, const QColor& color,
     glDisable(GL_POINT_SMOOTH);
   glColor4f(color.redF(), color.greenF(), color.blueF(), color.alphaF());
 
-  glBegin(GL_POINTS);
-  for (int i = 0; i < vertices.getNumPoints(); ++i)
-    glVertex3f(vertices[i][0], vertices[i][1], vertices[i][2]);
-  glEnd();
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(3, GL_DOUBLE, sizeof(Points<double, 3>::Point),
+    vertices[0].data());
+  glDrawArrays(GL_POINTS, 0, vertices.getNumPoints());
+  glDisableClientState(GL_VERTEX_ARRAY);
 
   glDisable(GL_POINT_SMOOTH);
   glPointSize(1.0);
@@ -236,32 +226,137 @@ void GLView::render(const Points<double, 3>& vertices, const QColor& color,
 void GLView::render(const Points<double, 3>& vertices, const
     std::vector<double>& weights, const QColor& fromColor, const QColor&
     toColor, double fromSize, double toSize, bool smooth){
+  if (!vertices.getNumPoints())
+    return;
+  loadTransformation();
   if (smooth)
     glEnable(GL_POINT_SMOOTH);
   else
     glDisable(GL_POINT_SMOOTH);
 
-  for (int i = 0; i < vertices.getNumPoints(); ++i) {
-    double size = (1.0-weights[i])*fromSize+weights[i]*toSize;
-    if (size > 1.0)
-      glPointSize(size);
-    else
-      glPointSize(1.0);
-
-    glBegin(GL_POINTS);
-    glColor4f((1.0-weights[i])*fromColor.redF()+weights[i]*toColor.redF(),
-      (1.0-weights[i])*fromColor.greenF()+weights[i]*toColor.greenF(),
-      (1.0-weights[i])*fromColor.blueF()+weights[i]*toColor.blueF(),
-      (1.0-weights[i])*fromColor.alphaF()+weights[i]*toColor.alphaF());
-    glVertex3f(vertices[i][0], vertices[i][1], vertices[i][2]);
-    glEnd();
+  size_t numSizeBins = std::min(fabs(toSize-fromSize)/sizeBinWidth+1.0,
+    (double)maxNumSizeBins);
+  if (sizeBins.size() < numSizeBins)
+    sizeBins.resize(numSizeBins);
+  for (size_t i = 0; i < numSizeBins; ++i)
+    sizeBins[i].clear();
+
+  colors.resize(4*vertices.getNumPoints());
+  for (size_t i = 0; i < vertices.getNumPoints(); ++i) {
+    colors[4*i] = (1.0-weights[i])*fromColor.redF()+weights[i]*toColor.redF();
+    colors[4*i+1] = (1.0-weights[i])*fromColor.greenF()+
+      weights[i]*toColor.greenF();
+    colors[4*i+2] = (1.0-weights[i])*fromColor.blueF()+
+      weights[i]*toColor.blueF();
+    colors[4*i+3] = (1.0-weights[i])*fromColor.alphaF()+
+      weights[i]*toColor.alphaF();
+    double weight = std::max(0.0, std::min(1.0, weights[i]));
+    sizeBins[round(weight*(numSizeBins-1))].push_back(i);
   }
 
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  glVertexPointer(3, GL_DOUBLE, sizeof(Points<double, 3>::Point),
+    vertices[0].data());
+  glColorPointer(4, GL_FLOAT, 0, &colors[0]);
+  for (size_t i = 0; i < numSizeBins; ++i)
+    if (!sizeBins[i].empty()) {
+      double size = (numSizeBins > 1) ? fromSize+(toSize-fromSize)*i/
+        (numSizeBins-1) : fromSize;
+      if (size > 1.0)
+        glPointSize(size);
+      else
+        glPointSize(1.0);
+      glDrawElements(GL_POINTS, sizeBins[i].size(), GL_UNSIGNED_INT,
+        &sizeBins[i][0]);
+    }
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+
+  glDisable(GL_POINT_SMOOTH);
+  glPointSize(1.0);
+}
+
+void GLView::render(const PointCloud<float>& cloud, const QColor& color,
+    double size, bool smooth) {
+  if (cloud.isEmpty())
+    return;
+  loadTransformation();
+  if (size > 1.0)
+    glPointSize(size);
+  else
+    glPointSize(1.0);
+  if (smooth)
+    glEnable(GL_POINT_SMOOTH);
+  else
+    glDisable(GL_POINT_SMOOTH);
+  glColor4f(color.redF(), color.greenF(), color.blueF(), color.alphaF());
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  size_t numPoints = cloud.getNumPoints();
+  if (bindBuffer(cloud, numPoints)) {
+    glVertexPointer(3, GL_FLOAT, 0, 0);
+    glDrawArrays(GL_POINTS, 0, numPoints);
+    QGLBuffer::release(QGLBuffer::VertexBuffer);
+  }
+  else {
+    glVertexPointer(3, GL_FLOAT, 0, cloud.getPositions());
+    glDrawArrays(GL_POINTS, 0, numPoints);
+  }
+  glDisableClientState(GL_VERTEX_ARRAY);
+
+  glDisable(GL_POINT_SMOOTH);
+  glPointSize(1.0);
+}
+
+void GLView::render(const PointCloud<float>& cloud, const QColor& fromColor,
+    const QColor& toColor, double maxIntensity, double size, bool smooth) {
+  if (cloud.isEmpty())
+    return;
+  if (!cloud.getIntensities() || (maxIntensity <= 0.0)) {
+    render(cloud, fromColor, size, smooth);
+    return;
+  }
+  loadTransformation();
+  if (size > 1.0)
+    glPointSize(size);
+  else
+    glPointSize(1.0);
+  if (smooth)
+    glEnable(GL_POINT_SMOOTH);
+  else
+    glDisable(GL_POINT_SMOOTH);
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  size_t numPoints = cloud.getNumPoints();
+  if (bindBuffer(cloud, numPoints)) {
+    glVertexPointer(3, GL_FLOAT, 0, 0);
+    if (bindColorBuffer(cloud, fromColor, toColor, maxIntensity))
+      glColorPointer(4, GL_UNSIGNED_BYTE, 0, 0);
+    else {
+      QGLBuffer::release(QGLBuffer::VertexBuffer);
+      computeColors(cloud, fromColor, toColor, maxIntensity);
+      glColorPointer(4, GL_UNSIGNED_BYTE, 0, &intensityColors[0]);
+    }
+    glDrawArrays(GL_POINTS, 0, numPoints);
+    QGLBuffer::release(QGLBuffer::VertexBuffer);
+  }
+  else {
+    computeColors(cloud, fromColor, toColor, maxIntensity);
+    glVertexPointer(3, GL_FLOAT, 0, cloud.getPositions());
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, &intensityColors[0]);
+    glDrawArrays(GL_POINTS, 0, numPoints);
+  }
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+
   glDisable(GL_POINT_SMOOTH);
   glPointSize(1.0);
 }
 
 void GLView::render(const Line<double, 3>& edges, const QColor& color) {
+  loadTransformation();
   glColor4f(color.redF(), color.greenF(), color.blueF(), color.alphaF());
 
   glBegin(GL_LINE_STRIP);
@@ -272,6 +367,7 @@ void GLView::render(const Line<double, 3>& edges, const QColor& color) {
 
 void GLView::render(const Line<double, 3>& edges, double weight, const QColor&
     fromColor, const QColor& toColor) {
+  loadTransformation();
   glColor4f((1.0-weight)*fromColor.redF()+weight*toColor.redF(),
     (1.0-weight)*fromColor.greenF()+weight*toColor.greenF(),
     (1.0-weight)*fromColor.blueF()+weight*toColor.blueF(),
@@ -283,7 +379,29 @@ void GLView::render(const Line<double, 3>& edges, double weight, const QColor&
   glEnd();
 }
 
+void GLView::renderSegments(const PointCloud<float>& segments, const QColor&
+    color) {
+  if (segments.getNumPoints() < 2)
+    return;
+  loadTransformation();
+  glColor4f(color.redF(), color.greenF(), color.blueF(), color.alphaF());
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  size_t numPoints = segments.getNumPoints();
+  if (bindBuffer(segments, numPoints)) {
+    glVertexPointer(3, GL_FLOAT, 0, 0);
+    glDrawArrays(GL_LINES, 0, numPoints);
+    QGLBuffer::release(QGLBuffer::VertexBuffer);
+  }
+  else {
+    glVertexPointer(3, GL_FLOAT, 0, segments.getPositions());
+    glDrawArrays(GL_LINES, 0, numPoints);
+  }
+  glDisableClientState(GL_VERTEX_ARRAY);
+}
+
 void GLView::render(const QString& text, const QColor& color) {
+  loadTransformation();
   glColor4f(color.redF(), color.greenF(), color.blueF(), color.alphaF());
 
   if (!font) {
@@ -295,14 +413,8 @@ void GLView::render(const QString& text, const QColor& color) {
     }
   }
 
-  if (font)
+  if (font && !callTextList(text))
     font->Render(text.toAscii().constData());
-
-  // memory leak in FTGL
-  if (font) {
-    delete font;
-    font = 0;
-  }
 }
 
 void GLView::render(const Ellipsoid<double, 3>& ellipsoid, size_t numSegments,
@@ -313,6 +425,7 @@ void GLView::render(const Ellipsoid<double, 3>& ellipsoid, size_t numSegments,
     translate(ellipsoid.getOrigin());
     rotate(ellipsoid.getOrientation());
     scale(ellipsoid.getSize());
+    loadTransformation();
 
     glEnable(GL_LIGHTING);
 
@@ -329,6 +442,391 @@ void GLView::render(const Ellipsoid<double, 3>& ellipsoid, size_t numSegments,
     View::render(ellipsoid, numSegments, color);
 }
 
+void GLView::loadTransformation() {
+  if (projectionChanged) {
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixd(projection.data());
+    projectionChanged = false;
+  }
+  if (transformationChanged) {
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixd(transformation.data());
+    transformationChanged = false;
+  }
+}
+
+void GLView::beginTiming(const QObject& control) {
+  View::beginTiming(control);
+
+  if (!timerQueryActive && hasTimerQueries()) {
+    TimerQuery timerQuery;
+    timerQuery.name = timingName;
+
+    if (freeTimerQueries.empty())
+      genQueries(1, &timerQuery.query);
+    else {
+      timerQuery.query = freeTimerQueries.back();
+      freeTimerQueries.pop_back();
+    }
+
+    beginQuery(GL_TIME_ELAPSED, timerQuery.query);
+    timerQueries.push_back(timerQuery);
+    timerQueryActive = true;
+  }
+}
+
+void GLView::endTiming() {
+  if (timerQueryActive) {
+    endQuery(GL_TIME_ELAPSED);
+    timerQueryActive = false;
+  }
+
+  View::endTiming();
+}
+
+bool GLView::bindBuffer(const PointCloud<float>& cloud, size_t& numPoints) {
+  if (QGLContext::currentContext() != ui->display->context())
+    return false;
+
+  CloudBuffer& cloudBuffer = cloudBuffers[cloud.getId()];
+  if (!cloudBuffer.buffer) {
+    cloudBuffer.buffer.reset(new QGLBuffer(QGLBuffer::VertexBuffer));
+    cloudBuffer.buffer->setUsagePattern(QGLBuffer::StaticDraw);
+    if (!cloudBuffer.buffer->create()) {
+      cloudBuffers.erase(cloud.getId());
+      return false;
+    }
+    cloudBuffer.token = cloud.getToken();
+    cloudBuffer.revision = cloud.getRevision() + 1;
+  }
+  cloudBuffer.buffer->bind();
+  if (cloudBuffer.revision != cloud.getRevision()) {
+    cloudBuffer.buffer->allocate(cloud.getPositions(),
+      3 * cloud.getNumPoints() * sizeof(float));
+    cloudBuffer.revision = cloud.getRevision();
+    cloudBuffer.numPoints = cloud.getNumPoints();
+  }
+  cloudBuffer.frame = frame;
+  numPoints = cloudBuffer.numPoints;
+
+  return true;
+}
+
+bool GLView::bindColorBuffer(const PointCloud<float>& cloud, const QColor&
+    fromColor, const QColor& toColor, double maxIntensity) {
+  std::unordered_map<size_t, CloudBuffer>::iterator it =
+    cloudBuffers.find(cloud.getId());
+  if (it == cloudBuffers.end())
+    return false;
+
+  CloudBuffer& cloudBuffer = it->second;
+  if (!cloudBuffer.colorBuffer) {
+    cloudBuffer.colorBuffer.reset(new QGLBuffer(QGLBuffer::VertexBuffer));
+    cloudBuffer.colorBuffer->setUsagePattern(QGLBuffer::StaticDraw);
+    if (!cloudBuffer.colorBuffer->create()) {
+      cloudBuffer.colorBuffer.reset();
+      return false;
+    }
+    cloudBuffer.colorRevision = cloud.getRevision() + 1;
+  }
+  cloudBuffer.colorBuffer->bind();
+  if ((cloudBuffer.colorRevision != cloud.getRevision()) ||
+      (cloudBuffer.fromColor != fromColor.rgba()) ||
+      (cloudBuffer.toColor != toColor.rgba()) ||
+      (cloudBuffer.maxIntensity != maxIntensity)) {
+    computeColors(cloud, fromColor, toColor, maxIntensity);
+    cloudBuffer.colorBuffer->allocate(&intensityColors[0],
+      intensityColors.size());
+    cloudBuffer.colorRevision = cloud.getRevision();
+    cloudBuffer.fromColor = fromColor.rgba();
+    cloudBuffer.toColor = toColor.rgba();
+    cloudBuffer.maxIntensity = maxIntensity;
+  }
+
+  return true;
+}
+
+void GLView::computeColors(const PointCloud<float>& cloud, const QColor&
+    fromColor, const QColor& toColor, double maxIntensity) {
+  const float* intensities = cloud.getIntensities();
+  intensityColors.resize(4*cloud.getNumPoints());
+  for (size_t i = 0; i < cloud.getNumPoints(); ++i) {
+    double weight = std::max(0.0, std::min(1.0, intensities[i]/maxIntensity));
+    intensityColors[4*i] = (1.0-weight)*fromColor.red()+
+      weight*toColor.red();
+    intensityColors[4*i+1] = (1.0-weight)*fromColor.green()+
+      weight*toColor.green();
+    intensityColors[4*i+2] = (1.0-weight)*fromColor.blue()+
+      weight*toColor.blue();
+    intensityColors[4*i+3] = (1.0-weight)*fromColor.alpha()+
+      weight*toColor.alpha();
+  }
+}
+
+bool GLView::updateTexture(const std::string& serial, const QImage& image,
+    size_t imageId) {
+  if (QGLContext::currentContext() != ui->display->context())
+    return false;
+
+  std::unordered_map<std::string, ImageTexture>::iterator it =
+    imageTextures.find(serial);
+  if (it == imageTextures.end()) {
+    ImageTexture imageTexture;
+    glGenTextures(1, &imageTexture.texture);
+    glBindTexture(GL_TEXTURE_2D, imageTexture.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    for (size_t i = 0; i < 2; ++i) {
+      imageTexture.pixelBuffers[i].reset(
+        new QGLBuffer(QGLBuffer::PixelUnpackBuffer));
+      imageTexture.pixelBuffers[i]->setUsagePattern(QGLBuffer::StreamDraw);
+      if (!imageTexture.pixelBuffers[i]->create()) {
+        imageTexture.pixelBuffers[0].reset();
+        imageTexture.pixelBuffers[1].reset();
+        break;
+      }
+    }
+    imageTexture.pixelBuffer = 0;
+    imageTexture.pixelBufferFilled = false;
+    imageTexture.imageId = imageId;
+    imageTexture.frame = frame;
+
+    it = imageTextures.insert(std::make_pair(serial, imageTexture)).first;
+  }
+  ImageTexture& imageTexture = it->second;
+
+  QImage rgbImage = (image.format() == QImage::Format_RGB32) ? image :
+    image.convertToFormat(QImage::Format_RGB32);
+  imageTexture.imageId = imageId;
+
+  if (imageTexture.pixelBuffers[0]) {
+    // The texture is updated from the buffer filled on the previous call
+    // while the new image is written into the other one, so the transfer
+    // of one buffer overlaps with the memcpy into the next
+    uploadTexture(imageTexture);
+
+    QGLBuffer& pixelBuffer =
+      *imageTexture.pixelBuffers[imageTexture.pixelBuffer];
+    pixelBuffer.bind();
+    pixelBuffer.allocate(rgbImage.byteCount());
+    void* data = pixelBuffer.map(QGLBuffer::WriteOnly);
+    if (data) {
+      memcpy(data, rgbImage.constBits(), rgbImage.byteCount());
+      pixelBuffer.unmap();
+      imageTexture.pixelBufferFilled = true;
+      imageTexture.pixelBufferSize = rgbImage.size();
+      imageTexture.pixelBuffer = 1-imageTexture.pixelBuffer;
+    }
+    QGLBuffer::release(QGLBuffer::PixelUnpackBuffer);
+    if (data)
+      return true;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, imageTexture.texture);
+  resizeTexture(imageTexture, rgbImage.size());
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rgbImage.width(),
+    rgbImage.height(), GL_BGRA, GL_UNSIGNED_BYTE, rgbImage.constBits());
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  return true;
+}
+
+void GLView::uploadTexture(ImageTexture& imageTexture) {
+  if (!imageTexture.pixelBufferFilled)
+    return;
+
+  glBindTexture(GL_TEXTURE_2D, imageTexture.texture);
+  resizeTexture(imageTexture, imageTexture.pixelBufferSize);
+  imageTexture.pixelBuffers[1-imageTexture.pixelBuffer]->bind();
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, imageTexture.size.width(),
+    imageTexture.size.height(), GL_BGRA, GL_UNSIGNED_BYTE, 0);
+  QGLBuffer::release(QGLBuffer::PixelUnpackBuffer);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  imageTexture.pixelBufferFilled = false;
+}
+
+void GLView::resizeTexture(ImageTexture& imageTexture, const QSize& size) {
+  if (imageTexture.size == size)
+    return;
+
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.width(), size.height(), 0,
+    GL_BGRA, GL_UNSIGNED_BYTE, 0);
+  imageTexture.size = size;
+}
+
+void GLView::clearTextures() {
+  for (std::unordered_map<std::string, ImageTexture>::iterator it =
+      imageTextures.begin(); it != imageTextures.end(); ++it)
+    glDeleteTextures(1, &it->second.texture);
+  imageTextures.clear();
+}
+
+bool GLView::callTextList(const QString& text) {
+  if (QGLContext::currentContext() != ui->display->context())
+    return false;
+
+  std::map<QString, TextList>::iterator it = textLists.find(text);
+  if (it == textLists.end()) {
+    if (textLists.size() >= maxNumTextLists) {
+      std::map<QString, TextList>::iterator oldest = textLists.begin();
+      for (std::map<QString, TextList>::iterator jt = textLists.begin();
+          jt != textLists.end(); ++jt)
+        if (jt->second.lastUsed < oldest->second.lastUsed)
+          oldest = jt;
+      glDeleteLists(oldest->second.list, 1);
+      textLists.erase(oldest);
+    }
+
+    TextList textList;
+    textList.list = glGenLists(1);
+    if (!textList.list)
+      return false;
+    glNewList(textList.list, GL_COMPILE);
+    font->Render(text.toAscii().constData());
+    glEndList();
+    it = textLists.insert(std::make_pair(text, textList)).first;
+  }
+  it->second.lastUsed = textListUses++;
+  glCallList(it->second.list);
+
+  return true;
+}
+
+void GLView::clearTextLists() {
+  for (std::map<QString, TextList>::iterator it = textLists.begin();
+      it != textLists.end(); ++it)
+    glDeleteLists(it->second.list, 1);
+  textLists.clear();
+}
+
+void GLView::releaseBuffers() {
+  size_t bufferMemory = 0;
+  std::vector<std::pair<size_t, size_t> > unusedBuffers;
+  // Buffers of destroyed clouds are released right away, those of culled
+  // clouds once they are too old or least recently used over the budget
+  for (auto it = cloudBuffers.begin(); it != cloudBuffers.end(); )
+    if (it->second.token.expired() || (frame-it->second.frame > maxBufferAge))
+      it = cloudBuffers.erase(it);
+    else {
+      bufferMemory += it->second.numPoints*(3*sizeof(float)+
+        (it->second.colorBuffer ? 4 : 0));
+      if (it->second.frame != frame)
+        unusedBuffers.push_back(std::make_pair(it->second.frame, it->first));
+      ++it;
+    }
+  if (bufferMemory > maxBufferMemory) {
+    std::sort(unusedBuffers.begin(), unusedBuffers.end());
+    for (size_t i = 0; (i < unusedBuffers.size()) &&
+        (bufferMemory > maxBufferMemory); ++i) {
+      const CloudBuffer& cloudBuffer = cloudBuffers[unusedBuffers[i].second];
+      bufferMemory -= cloudBuffer.numPoints*(3*sizeof(float)+
+        (cloudBuffer.colorBuffer ? 4 : 0));
+      cloudBuffers.erase(unusedBuffers[i].second);
+    }
+  }
+  for (auto it = imageTextures.begin(); it != imageTextures.end(); )
+    if (frame-it->second.frame > maxBufferAge) {
+      glDeleteTextures(1, &it->second.texture);
+      it = imageTextures.erase(it);
+    }
+    else
+      ++it;
+  ++frame;
+}
+
+bool GLView::hasTimerQueries() {
+  if (QGLContext::currentContext() != ui->display->context())
+    return false;
+
+  if (!timerQueriesResolved) {
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    const QGLContext* context = ui->display->context();
+
+    if (extensions && (strstr(extensions, "GL_ARB_timer_query") ||
+        strstr(extensions, "GL_EXT_timer_query"))) {
+      genQueries = (GenQueries)context->getProcAddress("glGenQueries");
+      deleteQueries = (DeleteQueries)context->getProcAddress(
+        "glDeleteQueries");
+      beginQuery = (BeginQuery)context->getProcAddress("glBeginQuery");
+      endQuery = (EndQuery)context->getProcAddress("glEndQuery");
+      getQueryObjectiv = (GetQueryObjectiv)context->getProcAddress(
+        "glGetQueryObjectiv");
+      getQueryObjectui64v = (GetQueryObjectui64v)context->getProcAddress(
+        "glGetQueryObjectui64v");
+      if (!getQueryObjectui64v)
+        getQueryObjectui64v = (GetQueryObjectui64v)context->getProcAddress(
+          "glGetQueryObjectui64vEXT");
+    }
+
+    if (!genQueries || !deleteQueries || !beginQuery || !endQuery ||
+        !getQueryObjectiv || !getQueryObjectui64v)
+      genQueries = 0;
+    timerQueriesResolved = true;
+  }
+
+  return genQueries;
+}
+
+void GLView::collectTimerQueries() {
+  if (!hasTimerQueries())
+    return;
+
+  while (!timerQueries.empty()) {
+    GLint available = 0;
+    getQueryObjectiv(timerQueries.front().query, GL_QUERY_RESULT_AVAILABLE,
+      &available);
+    if (!available)
+      break;
+
+    quint64 time = 0;
+    getQueryObjectui64v(timerQueries.front().query, GL_QUERY_RESULT, &time);
+    addGpuTime(timerQueries.front().name, time*1e-6);
+
+    freeTimerQueries.push_back(timerQueries.front().query);
+    timerQueries.pop_front();
+  }
+}
+
+void GLView::clearTimerQueries() {
+  if (genQueries) {
+    for (std::deque<TimerQuery>::const_iterator it = timerQueries.begin();
+        it != timerQueries.end(); ++it)
+      deleteQueries(1, &it->query);
+    if (!freeTimerQueries.empty())
+      deleteQueries(freeTimerQueries.size(), &freeTimerQueries[0]);
+  }
+
+  timerQueries.clear();
+  freeTimerQueries.clear();
+}
+
+void GLView::renderTimings() {
+  QFont overlayFont("Monospace", 9);
+  overlayFont.setStyleHint(QFont::TypeWriter);
+  int lineHeight = QFontMetrics(overlayFont).height();
+  int y = lineHeight;
+
+  glDisable(GL_FOG);
+  glDisable(GL_LIGHTING);
+  ui->display->qglColor(Qt::white);
+
+  ui->display->renderText(lineHeight, y, QString().sprintf(
+    "frame %7.2f ms, %lu dropped updates", frameTime,
+    (unsigned long)numDroppedUpdates), overlayFont);
+  for (Timings::const_iterator it = timings.begin(); it != timings.end();
+      ++it) {
+    y += lineHeight;
+    QString line = QString("%1").arg(it->first, -40)+QString().sprintf(
+      " cpu %7.2f ms (max %7.2f)", it->second.cpuTime, it->second.maxCpuTime);
+    if (it->second.numGpuSamples)
+      line += QString().sprintf(" gpu %7.2f ms", it->second.gpuTime);
+    ui->display->renderText(lineHeight, y, line, overlayFont);
+  }
+}
+
 bool GLView::dumpFrame(const QString& filename, size_t width, size_t height) {
   static bool dumping = false;
 
@@ -348,6 +846,11 @@ void GLView::update() {
 }
 
 void GLView::render() {
+  beginFrame();
+  collectTimerQueries();
+
+  resetTransformation();
+  beginStage("prepare");
   emit prepare(*this);
 
   glEnable(GL_LIGHT0);
@@ -356,6 +859,7 @@ void GLView::render() {
   glShadeModel(GL_SMOOTH);
   glEnable(GL_NORMALIZE);
 
+  loadTransformation();
   float lightPosition[] = {0.0, 0.0, 1000.0, 0.0};
   float lightAmbient[] = {0.5, 0.5, 0.5, 1.0};
   float lightDiffuse[] = {0.75, 0.75, 0.75, 1.0};
@@ -367,8 +871,18 @@ void GLView::render() {
   glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE);
   glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_FALSE);
 
+  beginStage("render");
   emit render(*this);
+  beginStage("cleanup");
   emit cleanup(*this);
+
+  if (QGLContext::currentContext() == ui->display->context()) {
+    releaseBuffers();
+    if (showTimingsAction->isChecked())
+      renderTimings();
+  }
+
+  endFrame();
 }
 
 void GLView::dumpFrame() {
@@ -428,20 +942,57 @@ void GLView::dumpAllToggled(bool checked) {
 void GLView::render(const QImage& image, const QRectF& target,
     const Transformation& transformation, const std::string& serial,
     size_t imageId) {
-//  saveTransformation();
-//  translate(transformation.translation());
-//  Eigen::Vector3d angles = transformation.rotation().eulerAngles(2, 1, 0);
-//  rotate(angles);
-//  static GLuint textureID = -1;
-//  static int prevImageId = -1;
-//  if (imageId != prevImageId) {
-//    if (textureID > 0)
-//      getDisplay().deleteTexture(textureID);
-//    textureID = getDisplay().bindTexture(image, GL_TEXTURE_2D, GL_LUMINANCE);
-//  }
-//  QColor color = Qt::lightGray;
-//  glColor4f(color.redF(), color.greenF(), color.blueF(), color.alphaF());
-//  getDisplay().drawTexture(target, textureID);
-//  prevImageId = imageId;
-//  restoreTransformation();
+  if (QGLContext::currentContext() != ui->display->context())
+    return;
+
+  bool updated = false;
+  if (!image.isNull() && needsImage(serial, imageId))
+    updated = updateTexture(serial, image, imageId);
+
+  std::unordered_map<std::string, ImageTexture>::iterator it =
+    imageTextures.find(serial);
+  if (it == imageTextures.end())
+    return;
+  // Without a new image, the one still waiting in a pixel buffer is
+  // uploaded now instead of on the next update
+  if (!updated)
+    uploadTexture(it->second);
+  if (!it->second.size.isValid())
+    return;
+  it->second.frame = frame;
+
+  // The image is centered on the optical axis, one image width in front of
+  // the camera
+  QRectF rect = target.translated(-target.center());
+  saveTransformation();
+  transform(transformation);
+  loadTransformation();
+
+  glEnable(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, it->second.texture);
+  glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+  glBegin(GL_QUADS);
+  glTexCoord2f(0.0, 0.0);
+  glVertex3f(rect.left(), rect.top(), target.width());
+  glTexCoord2f(1.0, 0.0);
+  glVertex3f(rect.right(), rect.top(), target.width());
+  glTexCoord2f(1.0, 1.0);
+  glVertex3f(rect.right(), rect.bottom(), target.width());
+  glTexCoord2f(0.0, 1.0);
+  glVertex3f(rect.left(), rect.bottom(), target.width());
+  glEnd();
+  glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glDisable(GL_TEXTURE_2D);
+
+  restoreTransformation();
+}
+
+bool GLView::needsImage(const std::string& serial, size_t imageId) const {
+  if (QGLContext::currentContext() != ui->display->context())
+    return false;
+
+  std::unordered_map<std::string, ImageTexture>::const_iterator it =
+    imageTextures.find(serial);
+  return (it == imageTextures.end()) || (it->second.imageId != imageId);
 }
@@ -21,7 +21,13 @@
 #ifndef GLVIEW_H
 #define GLVIEW_H
 
+#include <map>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
 #include <QtOpenGL/QGLWidget>
+#include <QtOpenGL/QGLBuffer>
 
 #include "gui/view.h"
 
@@ -52,28 +58,12 @@ public:
   Size getSize() const;
 
   Viewport getViewport() const;
-  void setProjection(const Projection& projection);
-  Projection getProjection() const;
-  void setTransformation(const Transformation& transformation);
-  Transformation getTransformation() const;
 
   void setDumpDirectory(const QString& dirname);
   void setDumpFrameSize(size_t width, size_t height);
   void setDumpFormat(const QString& format);
   void setDumpAll(bool dumpAll);
 
-  void saveTransformation();
-  void restoreTransformation();
-
-  void transform(const Transformation& transformation);
-  using View::transform;
-  void translate(const Translation& translation);
-  using View::translate;
-  void rotate(const Rotation& rotation);
-  using View::rotate;
-  void scale(const Scale& scale);
-  using View::scale;
-
   void clear(const QColor& color);
 
   void enableFog(const QColor& color, double start, double end,
@@ -82,14 +72,21 @@ public:
   void render(const QImage& image, const QRectF& target,
     const Transformation& transformation, const std::string& serial,
     size_t imageId);
+  bool needsImage(const std::string& serial, size_t imageId) const;
   void render(const Points<double, 3>& vertices, const QColor& color,
     double size, bool smooth);
   void render(const Points<double, 3>& vertices, const std::vector<double>&
     weights, const QColor& fromColor, const QColor& toColor, double fromSize,
     double toSize, bool smooth);
+  void render(const PointCloud<float>& cloud, const QColor& color,
+    double size, bool smooth);
+  void render(const PointCloud<float>& cloud, const QColor& fromColor,
+    const QColor& toColor, double maxIntensity, double size, bool smooth);
   void render(const Line<double, 3>& edges, const QColor& color);
   void render(const Line<double, 3>& edges, double weight, const QColor&
     fromColor, const QColor& toColor);
+  void renderSegments(const PointCloud<float>& segments, const QColor&
+    color);
   void render(const QString& text, const QColor& color);
 
   void render(const Ellipsoid<double, 3>& ellipsoid, size_t numSegments,
@@ -97,12 +94,76 @@ public:
 
   using View::render;
 
+  void beginTiming(const QObject& control);
+  void endTiming();
+
   bool dumpFrame(const QString& filename, size_t width, size_t height);
 public slots:
   void update();
   void render();
   void dumpFrame();
 protected:
+  struct CloudBuffer {
+    PointCloud<float>::Token token;
+    std::shared_ptr<QGLBuffer> buffer;
+    size_t revision;
+    size_t numPoints;
+    size_t frame;
+    std::shared_ptr<QGLBuffer> colorBuffer;
+    size_t colorRevision;
+    QRgb fromColor;
+    QRgb toColor;
+    double maxIntensity;
+  };
+
+  struct ImageTexture {
+    GLuint texture;
+    std::shared_ptr<QGLBuffer> pixelBuffers[2];
+    size_t pixelBuffer;
+    bool pixelBufferFilled;
+    QSize pixelBufferSize;
+    QSize size;
+    size_t imageId;
+    size_t frame;
+  };
+
+  struct TextList {
+    GLuint list;
+    size_t lastUsed;
+  };
+
+  struct TimerQuery {
+    GLuint query;
+    QString name;
+  };
+
+  typedef void (*GenQueries)(GLsizei n, GLuint* ids);
+  typedef void (*DeleteQueries)(GLsizei n, const GLuint* ids);
+  typedef void (*BeginQuery)(GLenum target, GLuint id);
+  typedef void (*EndQuery)(GLenum target);
+  typedef void (*GetQueryObjectiv)(GLuint id, GLenum name, GLint* params);
+  typedef void (*GetQueryObjectui64v)(GLuint id, GLenum name,
+    quint64* params);
+
+  void loadTransformation();
+  bool bindBuffer(const PointCloud<float>& cloud, size_t& numPoints);
+  bool bindColorBuffer(const PointCloud<float>& cloud, const QColor&
+    fromColor, const QColor& toColor, double maxIntensity);
+  void computeColors(const PointCloud<float>& cloud, const QColor&
+    fromColor, const QColor& toColor, double maxIntensity);
+  void releaseBuffers();
+  bool updateTexture(const std::string& serial, const QImage& image,
+    size_t imageId);
+  void uploadTexture(ImageTexture& imageTexture);
+  void resizeTexture(ImageTexture& imageTexture, const QSize& size);
+  void clearTextures();
+  bool callTextList(const QString& text);
+  void clearTextLists();
+  bool hasTimerQueries();
+  void collectTimerQueries();
+  void clearTimerQueries();
+  void renderTimings();
+
   Ui_GLView* ui;
 
   QAction* shadeAction;
@@ -111,6 +172,33 @@ protected:
   GLUquadricObj* quadric;
   FTPolygonFont* font;
 
+  static const size_t maxBufferMemory;
+  static const size_t maxBufferAge;
+  std::unordered_map<size_t, CloudBuffer> cloudBuffers;
+  std::unordered_map<std::string, ImageTexture> imageTextures;
+  size_t frame;
+
+  static const size_t maxNumTextLists;
+  std::map<QString, TextList> textLists;
+  size_t textListUses;
+
+  static const double sizeBinWidth;
+  static const size_t maxNumSizeBins;
+  std::vector<std::vector<GLuint> > sizeBins;
+  std::vector<float> colors;
+  std::vector<unsigned char> intensityColors;
+
+  bool timerQueriesResolved;
+  GenQueries genQueries;
+  DeleteQueries deleteQueries;
+  BeginQuery beginQuery;
+  EndQuery endQuery;
+  GetQueryObjectiv getQueryObjectiv;
+  GetQueryObjectui64v getQueryObjectui64v;
+  std::deque<TimerQuery> timerQueries;
+  std::vector<GLuint> freeTimerQueries;
+  bool timerQueryActive;
+
   QPoint mousePosition;
 protected slots:
   void mousePressed(const QPoint& position, Qt::MouseButtons buttons);
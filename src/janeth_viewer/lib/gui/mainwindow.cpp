@@ -99,6 +99,10 @@ void MainWindow::addView(const QString& title, View& view) {
 }
 
 void MainWindow::addControl(const QString& title, Control& control) {
+  if (control.objectName().isEmpty() ||
+      (control.objectName() == control.metaObject()->className()))
+    control.setObjectName(title);
+
   QAction* controlAction =
     ui->menuView->actions().at(1)->menu()->addAction(title);
 
@@ -18,8 +18,6 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
-#include <stdexcept>
-
 #include <QtGui/QFileDialog>
 #include <QtGui/QFontDialog>
 
@@ -34,9 +32,7 @@
 /*****************************************************************************/
 
 PlotView::PlotView() :
-  ui(new Ui_PlotView()),
-  projection(Projection::Identity()),
-  transformation(Transformation::Identity()) {
+  ui(new Ui_PlotView()) {
   ui->setupUi(this);
 
   menu.addAction("Set Font...", this, SLOT(fontBrowseClicked()));
@@ -85,22 +81,6 @@ PlotView::Size PlotView::getSize() const {
     ui->terminalHeightSpinBox->value());
 }
 
-void PlotView::setProjection(const Projection& projection) {
-  this->projection = projection;
-}
-
-PlotView::Projection PlotView::getProjection() const {
-  return projection;
-}
-
-void PlotView::setTransformation(const Transformation& transformation) {
-  this->transformation = transformation;
-}
-
-PlotView::Transformation PlotView::getTransformation() const {
-  return transformation;
-}
-
 void PlotView::setTerminalSize(double width, double height) {
   ui->terminalWidthSpinBox->setValue(width);
   ui->terminalHeightSpinBox->setValue(height);
@@ -110,51 +90,6 @@ void PlotView::setTerminalSize(double width, double height) {
 /* Methods                                                                   */
 /*****************************************************************************/
 
-void PlotView::saveTransformation() {
-  transformations.push_back(transformation);
-}
-
-void PlotView::restoreTransformation() {
-  if (!transformations.empty()) {
-    transformation = transformations.back();
-    transformations.pop_back();
-  }
-  else
-    throw std::runtime_error("Empty transformation stack");
-}
-
-void PlotView::transform(const Transformation& transformation) {
-  this->transformation = this->transformation*transformation;
-}
-
-void PlotView::translate(const Translation& translation) {
-  Transformation transformation;
-  transformation = Eigen::Translation<double, 3>(translation);
-
-  transform(transformation);
-}
-
-void PlotView::rotate(const Rotation& rotation) {
-  Eigen::AngleAxis<double> R_yaw(rotation[0],
-    Eigen::Matrix<double, 3, 1>::UnitZ());
-  Eigen::AngleAxis<double> R_pitch(rotation[1],
-    Eigen::Matrix<double, 3,1>::UnitY());
-  Eigen::AngleAxis<double> R_roll(rotation[2],
-    Eigen::Matrix<double, 3, 1>::UnitX());
-
-  Transformation transformation;
-  transformation = R_roll*R_pitch*R_yaw;
-
-  transform(transformation);
-}
-
-void PlotView::scale(const Scale& scale) {
-  Transformation transformation;
-  transformation = Eigen::Scaling(scale);
-
-  transform(transformation);
-}
-
 void PlotView::clear(const QColor& color) {
 }
 
@@ -177,6 +112,21 @@ void PlotView::render(const Points<double, 3>& vertices, const QColor& color,
     points.pop_back();
 }
 
+void PlotView::render(const PointCloud<float>& cloud, const QColor& color,
+    double size, bool smooth) {
+  std::vector<Points<double, 3> >& points = this->points[color.name()];
+
+  points.push_back(Points<double, 3>(0));
+  for (int i = 0; i < cloud.getNumPoints(); ++i) {
+    Point point = cloud.getPoint(i).cast<double>();
+    if (project(point))
+      points.back() += point;
+  }
+
+  if (!points.back().getNumPoints())
+    points.pop_back();
+}
+
 void PlotView::render(const Points<double, 3>& vertices, const
     std::vector<double>& weights, const QColor& fromColor, const QColor&
     toColor, double fromSize, double toSize, bool smooth) {
@@ -422,12 +372,9 @@ void PlotView::exportFrame(const QString& filename) {
 }
 
 void PlotView::render() {
-  projection = Projection::Identity();
-  transformation = Transformation::Identity();
+  resetTransformation();
 
   View::render();
-
-  transformations.clear();
 }
 
 bool PlotView::project(Point& point) const {
@@ -21,8 +21,6 @@
 #ifndef PLOTVIEW_H
 #define PLOTVIEW_H
 
-#include <list>
-
 #include <QtCore/QTextStream>
 #include <QtCore/QProcess>
 
@@ -51,25 +49,8 @@ public:
 
   Size getSize() const;
 
-  void setProjection(const Projection& projection);
-  Projection getProjection() const;
-  void setTransformation(const Transformation& transformation);
-  Transformation getTransformation() const;
-
   void setTerminalSize(double width, double height);
 
-  void saveTransformation();
-  void restoreTransformation();
-
-  void transform(const Transformation& transformation);
-  using View::transform;
-  void translate(const Translation& translation);
-  using View::translate;
-  void rotate(const Rotation& rotation);
-  using View::rotate;
-  void scale(const Scale& scale);
-  using View::scale;
-
   void clear(const QColor& color);
 
   void enableFog(const QColor& color, double start, double end,
@@ -83,6 +64,8 @@ public:
   void render(const Points<double, 3>& vertices, const std::vector<double>&
     weights, const QColor& fromColor, const QColor& toColor, double fromSize,
     double toSize, bool smooth);
+  void render(const PointCloud<float>& cloud, const QColor& color,
+    double size, bool smooth);
   void render(const Line<double, 3>& edges, const QColor& color);
   void render(const Line<double, 3>& edges, double weight, const QColor&
     fromColor, const QColor& toColor);
@@ -100,8 +83,6 @@ protected:
   QProcess conversionProcess;
   QString filename;
 
-  std::list<Transformation> transformations;
-
   std::map<QString, std::vector<Points<double, 3> > > points;
   std::map<QString, std::vector<Points<double, 3> > > palettePoints;
   std::map<QString, std::vector<std::vector<double> > > palettePointWeights;
@@ -110,9 +91,6 @@ protected:
   std::map<QString, std::vector<double> > paletteLineWeights;
   std::map<QString, std::vector<QString> > labels;
 
-  Projection projection;
-  Transformation transformation;
-
   bool project(Point& point) const;
   bool project(Line<double, 3>& line, std::vector<bool>& clipped) const;
   void interpolate(const Point& fixed, Point& variable, double ratio) const;
@@ -29,7 +29,11 @@
 /*****************************************************************************/
 
 SceneControl::SceneControl(bool showFog, bool showGround, bool showAxes) :
-  ui(new Ui_SceneControl()) {
+  ui(new Ui_SceneControl()),
+  groundGridRadius(-1.0),
+  groundGridElevation(0.0),
+  groundGridAngleStep(0.0),
+  groundGridRangeStep(0.0) {
   ui->setupUi(this);
 
   ui->colorChooser->setPalette(&palette);
@@ -185,30 +189,46 @@ void SceneControl::renderFog(View& view, const QColor& color, double start,
 
 void SceneControl::renderGround(View& view, const QColor& color, double radius,
     double elevation, double angleStep, double rangeStep) {
-  for (double theta = -M_PI; theta < M_PI; theta += angleStep) {
-    Line<double, 3> line;
-    line[0] = Line<double, 3>::Point(rangeStep*sin(theta),
-      rangeStep*cos(theta), elevation);
-    line[1] = Line<double, 3>::Point(radius*sin(theta),
-      radius*cos(theta), elevation);
+  if ((radius != groundGridRadius) || (elevation != groundGridElevation) ||
+      (angleStep != groundGridAngleStep) || (rangeStep != groundGridRangeStep))
+    updateGroundGrid(radius, elevation, angleStep, rangeStep);
+
+  view.renderSegments(groundGrid, color);
+}
+
+void SceneControl::updateGroundGrid(double radius, double elevation, double
+    angleStep, double rangeStep) {
+  typedef PointCloud<float>::Point Point;
+  groundGrid.clear();
 
-    view.render(line, color);
+  for (double theta = -M_PI; theta < M_PI; theta += angleStep) {
+    groundGrid.addPoint(Point(rangeStep*sin(theta), rangeStep*cos(theta),
+      elevation));
+    groundGrid.addPoint(Point(radius*sin(theta), radius*cos(theta),
+      elevation));
   }
-  
+
   for (double range = rangeStep; ; range += rangeStep) {
     if (range > radius)
       range = radius;
 
     double thetaStep = angleStep/range;
-    Line<double, 3> loop(2.0*M_PI/thetaStep, true);
-    for (int i = 0; i < loop.getNumPoints(); ++i)
-      loop[i] = Line<double, 3>::Point(range*sin(i*thetaStep),
-        range*cos(i*thetaStep), elevation);
-    view.render(loop, color);
+    int numPoints = 2.0*M_PI/thetaStep;
+    for (int i = 0; i < numPoints; ++i) {
+      groundGrid.addPoint(Point(range*sin(i*thetaStep),
+        range*cos(i*thetaStep), elevation));
+      groundGrid.addPoint(Point(range*sin((i+1)%numPoints*thetaStep),
+        range*cos((i+1)%numPoints*thetaStep), elevation));
+    }
 
     if (range == radius)
       break;
   }
+
+  groundGridRadius = radius;
+  groundGridElevation = elevation;
+  groundGridAngleStep = angleStep;
+  groundGridRangeStep = rangeStep;
 }
 
 void SceneControl::renderAxes(View& view, const QColor& color, double length) {
@@ -423,11 +443,14 @@ void SceneControl::transformView(View& view, const QPoint& fromMouse,
 }
 
 void SceneControl::prepareView(View& view) {
+  view.beginTiming(*this);
   camera.setup(view, view.getAspectRatio());
   scene.setup(view);
+  view.endTiming();
 }
 
 void SceneControl::renderView(View& view) {
+  view.beginTiming(*this);
   double radius = ui->groundXSpinBox->value();
 
   renderBackground(view, palette.getColor("Background"));
@@ -438,6 +461,7 @@ void SceneControl::renderView(View& view) {
       ui->groundZSpinBox->value(), 30.0*M_PI/180.0, 5.0);
   if (ui->showAxesCheckBox->isChecked())
     renderAxes(view, palette.getColor("Axes"), 0.5);
+  view.endTiming();
 }
 
 void SceneControl::poseUpdate(const Eigen::Affine3d& T_w_i) {
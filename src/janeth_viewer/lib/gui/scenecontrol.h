@@ -30,6 +30,8 @@
 #include "gui/camera.h"
 #include "gui/scene.h"
 
+#include "utils/PointCloud.h"
+
 class Ui_SceneControl;
 
 class SceneControl :
@@ -67,11 +69,19 @@ protected:
   Camera camera;
   Scene scene;
 
+  PointCloud<float> groundGrid;
+  double groundGridRadius;
+  double groundGridElevation;
+  double groundGridAngleStep;
+  double groundGridRangeStep;
+
   void renderBackground(View& view, const QColor& color);
   void renderFog(View& view, const QColor& color, double start, double end,
     double density);
   void renderGround(View& view, const QColor& color, double radius, double
     elevation, double angleStep, double rangeStep);
+  void updateGroundGrid(double radius, double elevation, double angleStep,
+    double rangeStep);
   void renderAxes(View& view, const QColor& color, double length);
 protected slots:
   void cameraPositionChanged();
@@ -18,24 +18,80 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+
+#include <QtGui/QFileDialog>
+
 #include "gui/view.h"
 
 #include "gui/framework.h"
 #include "gui/control.h"
 
+/*****************************************************************************/
+/* Statics                                                                   */
+/*****************************************************************************/
+
+const double View::defaultFrameRate = 30.0;
+const double View::timingSmoothing = 0.1;
+
 /*****************************************************************************/
 /* Constructors and Destructor                                               */
 /*****************************************************************************/
 
 View::View() :
-  menu(this) {
-  connect<Control>(SIGNAL(updateViews()), SLOT(update()));
+  menu(this),
+  frameRateActions(new QActionGroup(this)),
+  updatePending(false),
+  numDroppedUpdates(0),
+  projection(Projection::Identity()),
+  transformation(Transformation::Identity()),
+  projectionChanged(true),
+  transformationChanged(true),
+  timingStart(0),
+  frameStart(0),
+  frameTime(0.0) {
+  QMenu* frameRateMenu = menu.addMenu("Frame Rate");
+  const double frameRates[] = {10.0, 15.0, 30.0, 60.0, 0.0};
+  for (size_t i = 0; i < sizeof(frameRates)/sizeof(frameRates[0]); ++i) {
+    QAction* action = frameRateMenu->addAction(frameRates[i] ?
+      QString("%1 fps").arg(frameRates[i]) : QString("Unlimited"));
+    action->setData(frameRates[i]);
+    action->setCheckable(true);
+    frameRateActions->addAction(action);
+  }
+  showTimingsAction = menu.addAction("Show Timings", this,
+    SLOT(showTimingsClicked()), Qt::CTRL+Qt::Key_T);
+  showTimingsAction->setCheckable(true);
+  menu.addAction("Dump Timings...", this, SLOT(dumpTimingsClicked()));
+  menu.addSeparator();
+
+  connect(frameRateActions, SIGNAL(triggered(QAction*)), this,
+    SLOT(frameRateTriggered(QAction*)));
+  connect(&frameTimer, SIGNAL(timeout()), this, SLOT(frameTimerTimeout()));
+
+  setFrameRate(defaultFrameRate);
+  timingClock.start();
+
+  connect<Control>(SIGNAL(updateViews()), SLOT(requestUpdate()));
   connect<Control>(SIGNAL(flushViews()), SLOT(flush()));
 }
 
 View::~View() {
 }
 
+View::Timing::Timing() :
+  numCpuSamples(0),
+  cpuTime(0.0),
+  maxCpuTime(0.0),
+  numGpuSamples(0),
+  gpuTime(0.0) {
+}
+
 /*****************************************************************************/
 /* Accessors                                                                 */
 /*****************************************************************************/
@@ -48,6 +104,49 @@ const QMenu& View::getMenu() const {
   return menu;
 }
 
+void View::setProjection(const Projection& projection) {
+  this->projection = projection;
+  projectionChanged = true;
+}
+
+void View::setFrameRate(double frameRate) {
+  frameTimer.setInterval(frameRate > 0.0 ? 1e3/frameRate : 0);
+
+  QList<QAction*> actions = frameRateActions->actions();
+  for (int i = 0; i < actions.size(); ++i)
+    if (actions[i]->data().toDouble() == frameRate)
+      actions[i]->setChecked(true);
+}
+
+double View::getFrameRate() const {
+  return frameTimer.interval() ? 1e3/frameTimer.interval() : 0.0;
+}
+
+size_t View::getNumDroppedUpdates() const {
+  return numDroppedUpdates;
+}
+
+const View::Timings& View::getTimings() const {
+  return timings;
+}
+
+double View::getFrameTime() const {
+  return frameTime;
+}
+
+View::Projection View::getProjection() const {
+  return projection;
+}
+
+void View::setTransformation(const Transformation& transformation) {
+  this->transformation = transformation;
+  transformationChanged = true;
+}
+
+View::Transformation View::getTransformation() const {
+  return transformation;
+}
+
 double View::getAspectRatio() const {
   Size size = getSize();
   return size[0]/size[1];
@@ -57,6 +156,61 @@ double View::getAspectRatio() const {
 /* Methods                                                                   */
 /*****************************************************************************/
 
+void View::saveTransformation() {
+  transformations.push_back(transformation);
+}
+
+void View::restoreTransformation() {
+  if (!transformations.empty()) {
+    transformation = transformations.back();
+    transformations.pop_back();
+    transformationChanged = true;
+  }
+  else
+    throw std::runtime_error("Empty transformation stack");
+}
+
+void View::transform(const Transformation& transformation) {
+  this->transformation = this->transformation*transformation;
+  transformationChanged = true;
+}
+
+void View::translate(const Translation& translation) {
+  Transformation transformation;
+  transformation = Eigen::Translation<double, 3>(translation);
+
+  transform(transformation);
+}
+
+void View::rotate(const Rotation& rotation) {
+  Eigen::AngleAxis<double> R_yaw(rotation[0],
+    Eigen::Matrix<double, 3, 1>::UnitZ());
+  Eigen::AngleAxis<double> R_pitch(rotation[1],
+    Eigen::Matrix<double, 3,1>::UnitY());
+  Eigen::AngleAxis<double> R_roll(rotation[2],
+    Eigen::Matrix<double, 3, 1>::UnitX());
+
+  Transformation transformation;
+  transformation = R_roll*R_pitch*R_yaw;
+
+  transform(transformation);
+}
+
+void View::scale(const Scale& scale) {
+  Transformation transformation;
+  transformation = Eigen::Scaling(scale);
+
+  transform(transformation);
+}
+
+void View::resetTransformation() {
+  projection = Projection::Identity();
+  transformation = Transformation::Identity();
+  transformations.clear();
+  projectionChanged = true;
+  transformationChanged = true;
+}
+
 void View::translate(double x, double y, double z) {
   translate(Translation(x, y, z));
 }
@@ -266,6 +420,41 @@ void View::render(const Points<double, 3>& vertices, const QColor& color,
   render(vertices, color, size, smooth);
   restoreTransformation();
 }
+
+void View::render(const PointCloud<float>& cloud, const QColor& color,
+    double size, bool smooth, const Transformation& transformation) {
+  saveTransformation();
+  setTransformation(getTransformation() * transformation);
+  render(cloud, color, size, smooth);
+  restoreTransformation();
+}
+
+void View::render(const PointCloud<float>& cloud, const QColor& fromColor,
+    const QColor& toColor, double maxIntensity, double size, bool smooth) {
+  const float* intensities = cloud.getIntensities();
+  if (!intensities || (maxIntensity <= 0.0)) {
+    render(cloud, fromColor, size, smooth);
+    return;
+  }
+
+  Points<double, 3> vertices(cloud.getNumPoints());
+  std::vector<double> weights(cloud.getNumPoints());
+  for (size_t i = 0; i < cloud.getNumPoints(); ++i) {
+    vertices[i] = cloud.getPoint(i).cast<double>();
+    weights[i] = std::max(0.0, std::min(1.0, intensities[i]/maxIntensity));
+  }
+  render(vertices, weights, fromColor, toColor, size, size, smooth);
+}
+
+void View::render(const PointCloud<float>& cloud, const QColor& fromColor,
+    const QColor& toColor, double maxIntensity, double size, bool smooth,
+    const Transformation& transformation) {
+  saveTransformation();
+  setTransformation(getTransformation() * transformation);
+  render(cloud, fromColor, toColor, maxIntensity, size, smooth);
+  restoreTransformation();
+}
+
 void View::render(const Line<double, 3>& edges, const QColor& color,
     const Transformation& transformation) {
   saveTransformation();
@@ -274,6 +463,21 @@ void View::render(const Line<double, 3>& edges, const QColor& color,
   restoreTransformation();
 }
 
+bool View::needsImage(const std::string& serial, size_t imageId) const {
+  return false;
+}
+
+QSize View::getImageSize() const {
+  return QSize();
+}
+
+void View::renderSegments(const PointCloud<float>& segments, const QColor&
+    color) {
+  for (size_t i = 0; i+1 < segments.getNumPoints(); i += 2)
+    render(Line<double, 3>(segments.getPoint(i).cast<double>(),
+      segments.getPoint(i+1).cast<double>()), color);
+}
+
 void View::map(Point& point) const {
   Size size = getSize();
 
@@ -290,12 +494,184 @@ void View::unmap(Point& point) const {
   point[2] = 2.0*point[2]-1.0;
 }
 
+void View::update() {
+  QWidget::update();
+}
+
+bool View::isCulled(const Eigen::AlignedBox<double, 3>& bounds, const
+    Transformation& transformation) const {
+  if (bounds.isEmpty())
+    return true;
+
+  Eigen::Matrix<double, 4, 4> T = projection.matrix()*
+    this->transformation.matrix()*transformation.matrix();
+  size_t outside[6] = {0, 0, 0, 0, 0, 0};
+
+  for (size_t i = 0; i < 8; ++i) {
+    Vertex corner(
+      (i & 0x1) ? bounds.max()[0] : bounds.min()[0],
+      (i & 0x2) ? bounds.max()[1] : bounds.min()[1],
+      (i & 0x4) ? bounds.max()[2] : bounds.min()[2], 1.0);
+    Vertex v = T*corner;
+
+    for (size_t j = 0; j < 3; ++j) {
+      if (v[j] < -v[3])
+        ++outside[2*j];
+      if (v[j] > v[3])
+        ++outside[2*j+1];
+    }
+  }
+
+  for (size_t j = 0; j < 6; ++j)
+    if (outside[j] == 8)
+      return true;
+
+  return false;
+}
+
+double View::getProjectedSize(const Eigen::AlignedBox<double, 3>& bounds,
+    const Transformation& transformation) const {
+  Eigen::Matrix<double, 4, 4> T = projection.matrix()*
+    this->transformation.matrix()*transformation.matrix();
+  Vertex center;
+  center << bounds.center(), 1.0;
+  double w = T.row(3)*center;
+
+  if (w <= 0.0)
+    return std::numeric_limits<double>::infinity();
+
+  double scale = T.block<2, 3>(0, 0).norm()/sqrt(2.0);
+  return 0.5*bounds.diagonal().norm()*scale/w*getSize().maxCoeff();
+}
+
+void View::beginTiming(const QObject& control) {
+  timingName = control.metaObject()->className();
+  if (!control.objectName().isEmpty())
+    timingName += " ("+control.objectName()+")";
+  timingName += "::"+timingStage;
+
+  timingStart = timingClock.nsecsElapsed();
+}
+
+void View::endTiming() {
+  addCpuTime(timingName, (timingClock.nsecsElapsed()-timingStart)*1e-6);
+}
+
+void View::clearTimings() {
+  timings.clear();
+  frameTime = 0.0;
+}
+
+bool View::dumpTimings(const QString& filename) const {
+  QFile file(filename);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  QTextStream stream(&file);
+  stream << "name,cpu_samples,cpu_ms,cpu_max_ms,gpu_samples,gpu_ms\n";
+  stream << "frame," << (frameTime ? 1 : 0) << "," << frameTime << "," <<
+    frameTime << ",0,0\n";
+  for (Timings::const_iterator it = timings.begin(); it != timings.end();
+      ++it)
+    stream << it->first << "," << it->second.numCpuSamples << "," <<
+      it->second.cpuTime << "," << it->second.maxCpuTime << "," <<
+      it->second.numGpuSamples << "," << it->second.gpuTime << "\n";
+
+  return (stream.status() == QTextStream::Ok);
+}
+
+void View::beginFrame() {
+  frameStart = timingClock.nsecsElapsed();
+}
+
+void View::beginStage(const QString& stage) {
+  timingStage = stage;
+}
+
+void View::endFrame() {
+  double time = (timingClock.nsecsElapsed()-frameStart)*1e-6;
+  frameTime = frameTime ? (1.0-timingSmoothing)*frameTime+
+    timingSmoothing*time : time;
+}
+
+void View::addCpuTime(const QString& name, double time) {
+  Timing& timing = timings[name];
+
+  timing.cpuTime = timing.numCpuSamples ? (1.0-timingSmoothing)*
+    timing.cpuTime+timingSmoothing*time : time;
+  timing.maxCpuTime = std::max(timing.maxCpuTime, time);
+  ++timing.numCpuSamples;
+}
+
+void View::addGpuTime(const QString& name, double time) {
+  Timing& timing = timings[name];
+
+  timing.gpuTime = timing.numGpuSamples ? (1.0-timingSmoothing)*
+    timing.gpuTime+timingSmoothing*time : time;
+  ++timing.numGpuSamples;
+}
+
 void View::render() {
+  beginFrame();
+
+  beginStage("prepare");
   emit prepare(*this);
+  beginStage("render");
   emit render(*this);
+  beginStage("cleanup");
   emit cleanup(*this);
+
+  endFrame();
 }
 
 void View::flush() {
+  if (updatePending) {
+    updatePending = false;
+    update();
+  }
+
   Framework::sendPostedEvents(this, 0);
 }
+
+void View::requestUpdate() {
+  if (updatePending)
+    ++numDroppedUpdates;
+  updatePending = true;
+
+  if (!frameTimer.isActive())
+    frameTimerTimeout();
+}
+
+void View::showEvent(QShowEvent* event) {
+  Widget::showEvent(event);
+
+  if (updatePending && !frameTimer.isActive())
+    frameTimerTimeout();
+}
+
+void View::frameTimerTimeout() {
+  if (updatePending && isVisible()) {
+    updatePending = false;
+    update();
+
+    frameTimer.start();
+  }
+  else
+    frameTimer.stop();
+}
+
+void View::frameRateTriggered(QAction* action) {
+  setFrameRate(action->data().toDouble());
+}
+
+void View::showTimingsClicked() {
+  update();
+}
+
+void View::dumpTimingsClicked() {
+  QString filename = QFileDialog::getSaveFileName(this, "Save Timings",
+    "timings.csv", "CSV files (*.csv)");
+
+  if (!filename.isNull())
+    dumpTimings(filename);
+}
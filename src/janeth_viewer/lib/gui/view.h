@@ -21,13 +21,21 @@
 #ifndef VIEW_H
 #define VIEW_H
 
+#include <list>
+#include <map>
+
 #include <eigen3/Eigen/Geometry>
 
+#include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
+
 #include <QtGui/QMenu>
+#include <QtGui/QActionGroup>
 
 #include "gui/widget.h"
 
 #include "utils/points.h"
+#include "utils/PointCloud.h"
 #include "utils/line.h"
 #include "utils/box.h"
 #include "utils/pyramid.h"
@@ -51,28 +59,47 @@ public:
   typedef Eigen::Matrix<double, 3, 1> Point;
   typedef Eigen::Matrix<double, 4, 1> Vertex;
 
+  struct Timing {
+    Timing();
+
+    size_t numCpuSamples;
+    double cpuTime;
+    double maxCpuTime;
+    size_t numGpuSamples;
+    double gpuTime;
+  };
+
+  typedef std::map<QString, Timing> Timings;
+
   View();
   virtual ~View();
 
   QMenu& getMenu();
   const QMenu& getMenu() const;
 
+  void setFrameRate(double frameRate);
+  double getFrameRate() const;
+  size_t getNumDroppedUpdates() const;
+
+  const Timings& getTimings() const;
+  double getFrameTime() const;
+
   virtual Size getSize() const = 0;
 
-  virtual void setProjection(const Projection& projection) = 0;
-  virtual Projection getProjection() const = 0;
-  virtual void setTransformation(const Transformation& transformation) = 0;
-  virtual Transformation getTransformation() const = 0;
+  virtual void setProjection(const Projection& projection);
+  virtual Projection getProjection() const;
+  virtual void setTransformation(const Transformation& transformation);
+  virtual Transformation getTransformation() const;
 
   double getAspectRatio() const;
 
-  virtual void saveTransformation() = 0;
-  virtual void restoreTransformation() = 0;
+  virtual void saveTransformation();
+  virtual void restoreTransformation();
 
-  virtual void transform(const Transformation& transformation) = 0;
-  virtual void translate(const Translation& translation) = 0;
-  virtual void rotate(const Rotation& rotation) = 0;
-  virtual void scale(const Scale& scale) = 0;
+  virtual void transform(const Transformation& transformation);
+  virtual void translate(const Translation& translation);
+  virtual void rotate(const Rotation& rotation);
+  virtual void scale(const Scale& scale);
 
   void translate(double x, double y, double z);
   void rotate(double yaw, double pitch, double roll);
@@ -89,6 +116,11 @@ public:
   virtual void render(const Points<double, 3>& vertices, const
     std::vector<double>& weights, const QColor& fromColor, const QColor&
     toColor, double fromSize, double toSize, bool smooth) = 0;
+  virtual void render(const PointCloud<float>& cloud, const QColor& color,
+    double size, bool smooth) = 0;
+  virtual void render(const PointCloud<float>& cloud, const QColor&
+    fromColor, const QColor& toColor, double maxIntensity, double size,
+    bool smooth);
   virtual void render(const Line<double, 3>& edges,
     const QColor& color) = 0;
   virtual void render(const Line<double, 3>& edges, double weight,
@@ -97,11 +129,20 @@ public:
 
   virtual void render(const Points<double, 3>& vertices, const QColor& color,
     double size, bool smooth, const Transformation& transformation);
+  virtual void render(const PointCloud<float>& cloud, const QColor& color,
+    double size, bool smooth, const Transformation& transformation);
+  virtual void render(const PointCloud<float>& cloud, const QColor&
+    fromColor, const QColor& toColor, double maxIntensity, double size,
+    bool smooth, const Transformation& transformation);
   virtual void render(const Line<double, 3>& edges, const QColor& color,
     const Transformation& transformation);
+  virtual void renderSegments(const PointCloud<float>& segments, const
+    QColor& color);
   virtual void render(const QImage& image, const QRectF& target,
     const Transformation& transformation, const std::string& serial,
     size_t imageId) = 0;
+  virtual bool needsImage(const std::string& serial, size_t imageId) const;
+  virtual QSize getImageSize() const;
   virtual void render(const Box<double, 3>& box, const QColor& color);
   virtual void render(const Pyramid<double, 3>& pyramid, const QColor& color);
   virtual void render(const Ellipsoid<double, 3>& ellipsoid, size_t
@@ -116,11 +157,60 @@ public:
 
   void map(Point& point) const;
   void unmap(Point& point) const;
+  bool isCulled(const Eigen::AlignedBox<double, 3>& bounds, const
+    Transformation& transformation) const;
+  double getProjectedSize(const Eigen::AlignedBox<double, 3>& bounds, const
+    Transformation& transformation) const;
+
+  virtual void beginTiming(const QObject& control);
+  virtual void endTiming();
+  void clearTimings();
+  bool dumpTimings(const QString& filename) const;
 public slots:
+  virtual void update();
   virtual void render();
   virtual void flush();
+  void requestUpdate();
 protected:
+  static const double defaultFrameRate;
+  static const double timingSmoothing;
+
   QMenu menu;
+  QActionGroup* frameRateActions;
+  QAction* showTimingsAction;
+
+  QTimer frameTimer;
+  bool updatePending;
+  size_t numDroppedUpdates;
+
+  Projection projection;
+  Transformation transformation;
+  std::list<Transformation> transformations;
+  bool projectionChanged;
+  bool transformationChanged;
+
+  QElapsedTimer timingClock;
+  QString timingStage;
+  QString timingName;
+  qint64 timingStart;
+  qint64 frameStart;
+  double frameTime;
+  Timings timings;
+
+  void resetTransformation();
+
+  void beginFrame();
+  void beginStage(const QString& stage);
+  void endFrame();
+  void addCpuTime(const QString& name, double time);
+  void addGpuTime(const QString& name, double time);
+
+  void showEvent(QShowEvent* event);
+protected slots:
+  void frameTimerTimeout();
+  void frameRateTriggered(QAction* action);
+  void showTimingsClicked();
+  void dumpTimingsClicked();
 signals:
   void transform(View& view, const QPoint& fromMouse, const QPoint& toMouse,
     int wheel, Qt::MouseButtons mouseButtons);
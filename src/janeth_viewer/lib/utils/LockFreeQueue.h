@@ -0,0 +1,100 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file LockFreeQueue.h
+    \brief This file defines a bounded lock-free queue.
+  */
+
+#ifndef LOCKFREEQUEUE_H
+#define LOCKFREEQUEUE_H
+
+#include <cstddef>
+
+#include <vector>
+#include <atomic>
+
+/** The LockFreeQueue class represents a bounded lock-free queue for exactly
+    one producer and one consumer thread.
+    \brief Bounded single-producer single-consumer lock-free queue.
+  */
+template <typename T> class LockFreeQueue {
+  /** \name Private constructors
+    @{
+    */
+  /// Copy constructor
+  LockFreeQueue(const LockFreeQueue& other);
+  /// Assignment operator
+  LockFreeQueue& operator = (const LockFreeQueue& other);
+  /** @}
+    */
+
+public:
+  /** \name Constructors/destructor
+    @{
+    */
+  /// Constructs the queue with a given capacity
+  LockFreeQueue(size_t capacity);
+  /// Destructor
+  ~LockFreeQueue();
+  /** @}
+    */
+
+  /** \name Accessors
+    @{
+    */
+  /// Returns the capacity of the queue
+  size_t getCapacity() const;
+  /// Returns the number of elements in the queue
+  size_t getSize() const;
+  /// Returns true if the queue is empty
+  bool isEmpty() const;
+  /// Returns true if the queue is full
+  bool isFull() const;
+  /** @}
+    */
+
+  /** \name Methods
+    @{
+    */
+  /// Pushes an element, returns false if the queue is full (producer only)
+  bool push(const T& element);
+  /// Pops an element, returns false if the queue is empty (consumer only)
+  bool pop(T& element);
+  /// Clears the queue (neither producer nor consumer may be active)
+  void clear();
+  /** @}
+    */
+
+protected:
+  /** \name Protected members
+    @{
+    */
+  /// Storage, one slot larger than the capacity
+  std::vector<T> _elements;
+  /// Index of the next element to pop
+  std::atomic<size_t> _head;
+  /// Index of the next slot to push into
+  std::atomic<size_t> _tail;
+  /** @}
+    */
+
+};
+
+#include "utils/LockFreeQueue.tpp"
+
+#endif // LOCKFREEQUEUE_H
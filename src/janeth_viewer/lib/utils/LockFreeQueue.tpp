@@ -0,0 +1,94 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+template <typename T>
+LockFreeQueue<T>::LockFreeQueue(size_t capacity) :
+    _elements(capacity + 1),
+    _head(0),
+    _tail(0) {
+}
+
+template <typename T>
+LockFreeQueue<T>::~LockFreeQueue() {
+}
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+template <typename T>
+size_t LockFreeQueue<T>::getCapacity() const {
+  return _elements.size() - 1;
+}
+
+template <typename T>
+size_t LockFreeQueue<T>::getSize() const {
+  const size_t head = _head.load(std::memory_order_acquire);
+  const size_t tail = _tail.load(std::memory_order_acquire);
+  return (tail + _elements.size() - head) % _elements.size();
+}
+
+template <typename T>
+bool LockFreeQueue<T>::isEmpty() const {
+  return _head.load(std::memory_order_acquire) ==
+    _tail.load(std::memory_order_acquire);
+}
+
+template <typename T>
+bool LockFreeQueue<T>::isFull() const {
+  return (_tail.load(std::memory_order_acquire) + 1) % _elements.size() ==
+    _head.load(std::memory_order_acquire);
+}
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+template <typename T>
+bool LockFreeQueue<T>::push(const T& element) {
+  const size_t tail = _tail.load(std::memory_order_relaxed);
+  const size_t next = (tail + 1) % _elements.size();
+  if (next == _head.load(std::memory_order_acquire))
+    return false;
+  _elements[tail] = element;
+  _tail.store(next, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+bool LockFreeQueue<T>::pop(T& element) {
+  const size_t head = _head.load(std::memory_order_relaxed);
+  if (head == _tail.load(std::memory_order_acquire))
+    return false;
+  element = _elements[head];
+  _elements[head] = T();
+  _head.store((head + 1) % _elements.size(), std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+void LockFreeQueue<T>::clear() {
+  for (auto it = _elements.begin(); it != _elements.end(); ++it)
+    *it = T();
+  _head.store(0, std::memory_order_release);
+  _tail.store(0, std::memory_order_release);
+}
@@ -0,0 +1,72 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file MemoryStreamBuffer.h
+    \brief This file defines a stream buffer reading from memory in place.
+  */
+
+#ifndef MEMORYSTREAMBUFFER_H
+#define MEMORYSTREAMBUFFER_H
+
+#include <cstddef>
+
+#include <streambuf>
+
+/** The MemoryStreamBuffer class exposes a memory block to standard input
+    streams without copying it, unlike std::istringstream. The memory is not
+    owned and must outlive the buffer.
+    \brief Stream buffer reading from memory in place.
+  */
+template <typename C = char> class MemoryStreamBuffer :
+  public std::basic_streambuf<C> {
+  /** \name Private constructors
+    @{
+    */
+  /// Copy constructor
+  MemoryStreamBuffer(const MemoryStreamBuffer& other);
+  /// Assignment operator
+  MemoryStreamBuffer& operator = (const MemoryStreamBuffer& other);
+  /** @}
+    */
+
+public:
+  /** \name Constructors/destructor
+    @{
+    */
+  /// Constructs the buffer over a memory block
+  MemoryStreamBuffer(const C* data = 0, size_t size = 0);
+  /// Destructor
+  virtual ~MemoryStreamBuffer();
+  /** @}
+    */
+
+  /** \name Accessors
+    @{
+    */
+  /// Sets the memory block and rewinds the buffer
+  void setData(const C* data, size_t size);
+  /// Returns the number of characters left to read
+  size_t getNumAvailable() const;
+  /** @}
+    */
+
+};
+
+#include "utils/MemoryStreamBuffer.tpp"
+
+#endif // MEMORYSTREAMBUFFER_H
@@ -0,0 +1,45 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+template <typename C>
+MemoryStreamBuffer<C>::MemoryStreamBuffer(const C* data, size_t size) {
+  setData(data, size);
+}
+
+template <typename C>
+MemoryStreamBuffer<C>::~MemoryStreamBuffer() {
+}
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+template <typename C>
+void MemoryStreamBuffer<C>::setData(const C* data, size_t size) {
+  C* begin = const_cast<C*>(data);
+  this->setg(begin, begin, begin + size);
+}
+
+template <typename C>
+size_t MemoryStreamBuffer<C>::getNumAvailable() const {
+  return this->egptr() - this->gptr();
+}
@@ -0,0 +1,204 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file PointCloud.h
+    \brief This file defines a compact point cloud container.
+  */
+
+#ifndef POINTCLOUD_H
+#define POINTCLOUD_H
+
+#include <cstddef>
+
+#include <vector>
+#include <memory>
+#include <atomic>
+
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Geometry>
+
+/** The PointCloud class stores the positions of its points interleaved in
+    one contiguous, aligned array, such that it can be handed to OpenGL
+    vertex arrays or buffers without conversion. The optional intensity,
+    ring and timestamp channels are stored as separate arrays. The cloud
+    is move-only: copies have to be requested explicitly with clone().
+    Every cloud carries a unique identifier, which follows its content when
+    moved, and a revision, which changes whenever the content may change,
+    such that renderers can cache it on the GPU. The token of a cloud also
+    follows its content and expires when that content is destroyed, which
+    tells renderers when to release their cache.
+    \brief Compact point cloud container.
+  */
+template <typename T = float> class PointCloud {
+  /** \name Private constructors
+    @{
+    */
+  /// Copy constructor
+  PointCloud(const PointCloud& other);
+  /// Assignment operator
+  PointCloud& operator = (const PointCloud& other);
+  /** @}
+    */
+
+public:
+  /** \name Types definitions
+    @{
+    */
+  /// Point type
+  typedef Eigen::Matrix<T, 3, 1> Point;
+  /// Axis-aligned bounding box type
+  typedef Eigen::AlignedBox<T, 3> Bounds;
+  /// Array type for positions and scalar channels
+  typedef std::vector<T, Eigen::aligned_allocator<T> > Array;
+  /// Array type for the ring channel
+  typedef std::vector<unsigned char> RingArray;
+  /// Token type, expires with the content of the cloud
+  typedef std::weak_ptr<const void> Token;
+  /// Optional channels
+  enum Channels {
+    /// Positions only
+    Positions = 0x0,
+    /// Intensity of the points
+    Intensities = 0x1,
+    /// Laser ring the points were measured by
+    Rings = 0x2,
+    /// Timestamp of the points relative to the cloud
+    Timestamps = 0x4
+  };
+  /** @}
+    */
+
+  /** \name Constructors/destructor
+    @{
+    */
+  /// Constructs the cloud with a combination of channels and a size
+  PointCloud(int channels = Positions, size_t numPoints = 0);
+  /// Move constructor
+  PointCloud(PointCloud&& other);
+  /// Move assignment operator
+  PointCloud& operator = (PointCloud&& other);
+  /// Destructor
+  ~PointCloud();
+  /** @}
+    */
+
+  /** \name Accessors
+    @{
+    */
+  /// Returns the channels of the cloud
+  int getChannels() const;
+  /// Returns true if the cloud has a channel
+  bool hasChannel(Channels channel) const;
+  /// Returns the unique identifier of the cloud
+  size_t getId() const;
+  /// Returns the revision of the content of the cloud
+  size_t getRevision() const;
+  /// Returns the token of the content of the cloud
+  Token getToken() const;
+  /// Sets the number of points
+  void setNumPoints(size_t numPoints);
+  /// Returns the number of points
+  size_t getNumPoints() const;
+  /// Returns true if the cloud has no points
+  bool isEmpty() const;
+  /// Returns a point
+  Eigen::Map<Point> getPoint(size_t i);
+  /// Returns a point
+  Eigen::Map<const Point> getPoint(size_t i) const;
+  /// Returns the interleaved positions, 3 values per point
+  T* getPositions();
+  /// Returns the interleaved positions, 3 values per point
+  const T* getPositions() const;
+  /// Returns the intensities, null if the channel is missing
+  T* getIntensities();
+  /// Returns the intensities, null if the channel is missing
+  const T* getIntensities() const;
+  /// Returns the rings, null if the channel is missing
+  unsigned char* getRings();
+  /// Returns the rings, null if the channel is missing
+  const unsigned char* getRings() const;
+  /// Returns the timestamps, null if the channel is missing
+  T* getTimestamps();
+  /// Returns the timestamps, null if the channel is missing
+  const T* getTimestamps() const;
+  /// Returns the size of the cloud in memory in bytes
+  size_t getMemorySize() const;
+  /// Returns the bounding box of the points, empty if there are none
+  Bounds getBounds() const;
+  /** @}
+    */
+
+  /** \name Methods
+    @{
+    */
+  /// Reserves memory for a number of points
+  void reserve(size_t numPoints);
+  /// Adds a point, the values of missing channels are ignored
+  void addPoint(const Point& point, T intensity = T(0), unsigned char ring = 0,
+    T timestamp = T(0));
+  /// Appends interleaved positions, the other channels are zeroed
+  void append(const T* positions, size_t numPoints);
+  /// Appends the points of another cloud, missing channels are zeroed
+  void append(const PointCloud& other);
+  /// Returns a deep copy of the cloud
+  PointCloud clone() const;
+  /// Swaps the content with another cloud
+  void swap(PointCloud& other);
+  /// Removes all points
+  void clear();
+  /** @}
+    */
+
+protected:
+  /** \name Protected methods
+    @{
+    */
+  /// Resizes the channels to the number of positions
+  void resizeChannels();
+  /// Returns a new unique identifier
+  static size_t getNextId();
+  /** @}
+    */
+
+  /** \name Protected members
+    @{
+    */
+  /// Unique identifier of the cloud
+  size_t _id;
+  /// Revision of the content
+  size_t _revision;
+  /// Keeps the token of the content alive
+  std::shared_ptr<const void> _token;
+  /// Channels of the cloud
+  int _channels;
+  /// Interleaved positions
+  Array _positions;
+  /// Intensities
+  Array _intensities;
+  /// Rings
+  RingArray _rings;
+  /// Timestamps
+  Array _timestamps;
+  /** @}
+    */
+
+};
+
+#include "utils/PointCloud.tpp"
+
+#endif // POINTCLOUD_H
@@ -0,0 +1,271 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include <algorithm>
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+template <typename T>
+PointCloud<T>::PointCloud(int channels, size_t numPoints) :
+    _id(getNextId()),
+    _revision(0),
+    _token(std::make_shared<char>(0)),
+    _channels(channels) {
+  setNumPoints(numPoints);
+}
+
+template <typename T>
+PointCloud<T>::PointCloud(PointCloud&& other) :
+    _id(getNextId()),
+    _revision(0),
+    _token(std::make_shared<char>(0)),
+    _channels(other._channels) {
+  swap(other);
+}
+
+template <typename T>
+PointCloud<T>& PointCloud<T>::operator = (PointCloud&& other) {
+  if (this != &other) {
+    clear();
+    _channels = other._channels;
+    swap(other);
+  }
+  return *this;
+}
+
+template <typename T>
+PointCloud<T>::~PointCloud() {
+}
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+template <typename T>
+int PointCloud<T>::getChannels() const {
+  return _channels;
+}
+
+template <typename T>
+bool PointCloud<T>::hasChannel(Channels channel) const {
+  return _channels & channel;
+}
+
+template <typename T>
+size_t PointCloud<T>::getId() const {
+  return _id;
+}
+
+template <typename T>
+size_t PointCloud<T>::getRevision() const {
+  return _revision;
+}
+
+template <typename T>
+typename PointCloud<T>::Token PointCloud<T>::getToken() const {
+  return _token;
+}
+
+template <typename T>
+void PointCloud<T>::setNumPoints(size_t numPoints) {
+  ++_revision;
+  _positions.resize(3 * numPoints);
+  resizeChannels();
+}
+
+template <typename T>
+size_t PointCloud<T>::getNumPoints() const {
+  return _positions.size() / 3;
+}
+
+template <typename T>
+bool PointCloud<T>::isEmpty() const {
+  return _positions.empty();
+}
+
+template <typename T>
+Eigen::Map<typename PointCloud<T>::Point> PointCloud<T>::getPoint(size_t i) {
+  ++_revision;
+  return Eigen::Map<Point>(&_positions[3 * i]);
+}
+
+template <typename T>
+Eigen::Map<const typename PointCloud<T>::Point> PointCloud<T>::getPoint(
+    size_t i) const {
+  return Eigen::Map<const Point>(&_positions[3 * i]);
+}
+
+template <typename T>
+T* PointCloud<T>::getPositions() {
+  ++_revision;
+  return _positions.data();
+}
+
+template <typename T>
+const T* PointCloud<T>::getPositions() const {
+  return _positions.data();
+}
+
+template <typename T>
+T* PointCloud<T>::getIntensities() {
+  ++_revision;
+  return hasChannel(Intensities) ? _intensities.data() : 0;
+}
+
+template <typename T>
+const T* PointCloud<T>::getIntensities() const {
+  return hasChannel(Intensities) ? _intensities.data() : 0;
+}
+
+template <typename T>
+unsigned char* PointCloud<T>::getRings() {
+  ++_revision;
+  return hasChannel(Rings) ? _rings.data() : 0;
+}
+
+template <typename T>
+const unsigned char* PointCloud<T>::getRings() const {
+  return hasChannel(Rings) ? _rings.data() : 0;
+}
+
+template <typename T>
+T* PointCloud<T>::getTimestamps() {
+  ++_revision;
+  return hasChannel(Timestamps) ? _timestamps.data() : 0;
+}
+
+template <typename T>
+const T* PointCloud<T>::getTimestamps() const {
+  return hasChannel(Timestamps) ? _timestamps.data() : 0;
+}
+
+template <typename T>
+size_t PointCloud<T>::getMemorySize() const {
+  return sizeof(*this) + (_positions.capacity() + _intensities.capacity() +
+    _timestamps.capacity()) * sizeof(T) + _rings.capacity();
+}
+
+template <typename T>
+typename PointCloud<T>::Bounds PointCloud<T>::getBounds() const {
+  Bounds bounds;
+  for (size_t i = 0; i < _positions.size(); i += 3)
+    bounds.extend(Point(_positions[i], _positions[i + 1], _positions[i + 2]));
+  return bounds;
+}
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+template <typename T>
+void PointCloud<T>::reserve(size_t numPoints) {
+  _positions.reserve(3 * numPoints);
+  if (hasChannel(Intensities))
+    _intensities.reserve(numPoints);
+  if (hasChannel(Rings))
+    _rings.reserve(numPoints);
+  if (hasChannel(Timestamps))
+    _timestamps.reserve(numPoints);
+}
+
+template <typename T>
+void PointCloud<T>::addPoint(const Point& point, T intensity,
+    unsigned char ring, T timestamp) {
+  ++_revision;
+  _positions.push_back(point[0]);
+  _positions.push_back(point[1]);
+  _positions.push_back(point[2]);
+  if (hasChannel(Intensities))
+    _intensities.push_back(intensity);
+  if (hasChannel(Rings))
+    _rings.push_back(ring);
+  if (hasChannel(Timestamps))
+    _timestamps.push_back(timestamp);
+}
+
+template <typename T>
+void PointCloud<T>::append(const T* positions, size_t numPoints) {
+  ++_revision;
+  _positions.insert(_positions.end(), positions, positions + 3 * numPoints);
+  resizeChannels();
+}
+
+template <typename T>
+void PointCloud<T>::append(const PointCloud& other) {
+  const size_t numPoints = getNumPoints();
+  ++_revision;
+  _positions.insert(_positions.end(), other._positions.begin(),
+    other._positions.end());
+  resizeChannels();
+  if (hasChannel(Intensities) && other.hasChannel(Intensities))
+    std::copy(other._intensities.begin(), other._intensities.end(),
+      _intensities.begin() + numPoints);
+  if (hasChannel(Rings) && other.hasChannel(Rings))
+    std::copy(other._rings.begin(), other._rings.end(),
+      _rings.begin() + numPoints);
+  if (hasChannel(Timestamps) && other.hasChannel(Timestamps))
+    std::copy(other._timestamps.begin(), other._timestamps.end(),
+      _timestamps.begin() + numPoints);
+}
+
+template <typename T>
+PointCloud<T> PointCloud<T>::clone() const {
+  PointCloud<T> cloud(_channels);
+  cloud.append(*this);
+  return cloud;
+}
+
+template <typename T>
+void PointCloud<T>::swap(PointCloud& other) {
+  std::swap(_id, other._id);
+  std::swap(_revision, other._revision);
+  _token.swap(other._token);
+  std::swap(_channels, other._channels);
+  _positions.swap(other._positions);
+  _intensities.swap(other._intensities);
+  _rings.swap(other._rings);
+  _timestamps.swap(other._timestamps);
+}
+
+template <typename T>
+void PointCloud<T>::clear() {
+  ++_revision;
+  _positions.clear();
+  _intensities.clear();
+  _rings.clear();
+  _timestamps.clear();
+}
+
+template <typename T>
+void PointCloud<T>::resizeChannels() {
+  const size_t numPoints = getNumPoints();
+  if (hasChannel(Intensities))
+    _intensities.resize(numPoints);
+  if (hasChannel(Rings))
+    _rings.resize(numPoints);
+  if (hasChannel(Timestamps))
+    _timestamps.resize(numPoints);
+}
+
+template <typename T>
+size_t PointCloud<T>::getNextId() {
+  static std::atomic<size_t> nextId(0);
+  return nextId++;
+}
@@ -0,0 +1,180 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file PointOctree.h
+    \brief This file defines a level-of-detail point octree.
+  */
+
+#ifndef POINTOCTREE_H
+#define POINTOCTREE_H
+
+#include <cstddef>
+
+#include <bitset>
+#include <memory>
+
+#include <eigen3/Eigen/Geometry>
+
+#include "utils/PointCloud.h"
+
+/** The PointOctree class accumulates points in a world-space octree for
+    level-of-detail rendering. Every node keeps at most one point per cell of
+    a regular grid spanning its cube, and passes further points down to its
+    children, such that each node holds a spatially uniform sample whose
+    density doubles with every level. Nodes are not subdivided below the
+    finest resolution, and the root grows as points fall outside of it. When
+    the number of stored points exceeds the budget, the finest level is
+    dropped and the resolution halved, which bounds the memory.
+    \brief Level-of-detail point octree.
+  */
+template <typename T = float> class PointOctree {
+  /** \name Private constructors
+    @{
+    */
+  /// Copy constructor
+  PointOctree(const PointOctree& other);
+  /// Assignment operator
+  PointOctree& operator = (const PointOctree& other);
+  /** @}
+    */
+
+public:
+  /** \name Constants
+    @{
+    */
+  /// Number of grid cells along each axis of a node
+  static const size_t gridSize = 16;
+  /// Number of finest grid cells along each axis of the initial root
+  static const size_t rootSize = 1024;
+  /** @}
+    */
+
+  /** \name Types definitions
+    @{
+    */
+  /// Point cloud type
+  typedef PointCloud<T> Cloud;
+  /// Point type
+  typedef typename Cloud::Point Point;
+  /// Bounding box type
+  typedef typename Cloud::Bounds Bounds;
+  /// Transformation type
+  typedef Eigen::Transform<T, 3, Eigen::Affine> Transformation;
+  /// Octree node
+  class Node {
+  friend class PointOctree;
+  public:
+    /// Returns the cube of the node
+    const Bounds& getBounds() const;
+    /// Returns the points of the node
+    const Cloud& getPoints() const;
+    /// Returns a child, null if it does not exist
+    const Node* getChild(size_t i) const;
+  protected:
+    /// Cube of the node
+    Bounds _bounds;
+    /// Points of the node
+    Cloud _points;
+    /// Occupied cells of the node grid
+    std::bitset<gridSize * gridSize * gridSize> _cells;
+    /// Children of the node
+    std::unique_ptr<Node> _children[8];
+  };
+  /** @}
+    */
+
+  /** \name Constructors/destructor
+    @{
+    */
+  /// Constructs the octree with a finest resolution and a point budget
+  PointOctree(T resolution = T(0.05), size_t maxNumPoints = 4000000);
+  /// Destructor
+  ~PointOctree();
+  /** @}
+    */
+
+  /** \name Accessors
+    @{
+    */
+  /// Returns the current finest resolution
+  T getResolution() const;
+  /// Sets the point budget, coarsening the octree if needed
+  void setMaxNumPoints(size_t maxNumPoints);
+  /// Returns the point budget
+  size_t getMaxNumPoints() const;
+  /// Returns the number of stored points
+  size_t getNumPoints() const;
+  /// Returns the number of nodes
+  size_t getNumNodes() const;
+  /// Returns the root node, null if the octree is empty
+  const Node* getRoot() const;
+  /** @}
+    */
+
+  /** \name Methods
+    @{
+    */
+  /// Inserts the points of a cloud transformed into the octree frame
+  void insert(const Cloud& cloud, const Transformation& transformation);
+  /// Inserts a point
+  void insert(const Point& point);
+  /// Removes all points and restores the initial resolution
+  void clear();
+  /** @}
+    */
+
+protected:
+  /** \name Protected methods
+    @{
+    */
+  /// Creates a node for a cube
+  Node* createNode(const Bounds& bounds);
+  /// Grows the root until it contains a point
+  void grow(const Point& point);
+  /// Drops the finest level and halves the resolution
+  void coarsen();
+  /// Removes the descendants of a node smaller than a size
+  void prune(Node& node, T minSize);
+  /// Removes a node and its descendants from the statistics
+  void release(const Node& node);
+  /** @}
+    */
+
+  /** \name Protected members
+    @{
+    */
+  /// Initial finest resolution
+  T _initialResolution;
+  /// Current finest resolution
+  T _resolution;
+  /// Point budget
+  size_t _maxNumPoints;
+  /// Number of stored points
+  size_t _numPoints;
+  /// Number of nodes
+  size_t _numNodes;
+  /// Root node
+  std::unique_ptr<Node> _root;
+  /** @}
+    */
+
+};
+
+#include "utils/PointOctree.tpp"
+
+#endif // POINTOCTREE_H
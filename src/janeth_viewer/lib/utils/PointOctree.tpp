@@ -0,0 +1,215 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include <cmath>
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+template <typename T>
+PointOctree<T>::PointOctree(T resolution, size_t maxNumPoints) :
+    _initialResolution(resolution),
+    _resolution(resolution),
+    _maxNumPoints(maxNumPoints),
+    _numPoints(0),
+    _numNodes(0) {
+}
+
+template <typename T>
+PointOctree<T>::~PointOctree() {
+}
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+template <typename T>
+const typename PointOctree<T>::Bounds& PointOctree<T>::Node::getBounds()
+    const {
+  return _bounds;
+}
+
+template <typename T>
+const typename PointOctree<T>::Cloud& PointOctree<T>::Node::getPoints()
+    const {
+  return _points;
+}
+
+template <typename T>
+const typename PointOctree<T>::Node* PointOctree<T>::Node::getChild(size_t i)
+    const {
+  return _children[i].get();
+}
+
+template <typename T>
+T PointOctree<T>::getResolution() const {
+  return _resolution;
+}
+
+template <typename T>
+void PointOctree<T>::setMaxNumPoints(size_t maxNumPoints) {
+  _maxNumPoints = maxNumPoints;
+  while (_numPoints > _maxNumPoints)
+    coarsen();
+}
+
+template <typename T>
+size_t PointOctree<T>::getMaxNumPoints() const {
+  return _maxNumPoints;
+}
+
+template <typename T>
+size_t PointOctree<T>::getNumPoints() const {
+  return _numPoints;
+}
+
+template <typename T>
+size_t PointOctree<T>::getNumNodes() const {
+  return _numNodes;
+}
+
+template <typename T>
+const typename PointOctree<T>::Node* PointOctree<T>::getRoot() const {
+  return _root.get();
+}
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+template <typename T>
+void PointOctree<T>::insert(const Cloud& cloud, const Transformation&
+    transformation) {
+  for (size_t i = 0; i < cloud.getNumPoints(); ++i)
+    insert(Point(transformation * cloud.getPoint(i)));
+  while (_numPoints > _maxNumPoints)
+    coarsen();
+}
+
+template <typename T>
+void PointOctree<T>::insert(const Point& point) {
+  for (size_t j = 0; j < 3; ++j)
+    if (!std::isfinite(point[j]))
+      return;
+  if (!_root) {
+    const Point halfSize = Point::Constant(_resolution * rootSize / 2);
+    _root.reset(createNode(Bounds(point - halfSize, point + halfSize)));
+  }
+  else if (!_root->_bounds.contains(point))
+    grow(point);
+  const T minSize = _resolution * gridSize;
+  Node* node = _root.get();
+  while (true) {
+    const Point center = node->_bounds.center();
+    const T size = node->_bounds.sizes()[0];
+    size_t cellIdx = 0;
+    for (size_t j = 3; j > 0; --j) {
+      const T cell = std::floor((point[j - 1] - node->_bounds.min()[j - 1]) *
+        gridSize / size);
+      cellIdx = gridSize * cellIdx + (cell < 0 ? 0 :
+        (cell >= gridSize ? gridSize - 1 : (size_t)cell));
+    }
+    if (!node->_cells[cellIdx]) {
+      node->_cells[cellIdx] = true;
+      node->_points.addPoint(point);
+      ++_numPoints;
+      return;
+    }
+    if (size / 2 < T(0.75) * minSize)
+      return;
+    const size_t childIdx = (point[0] >= center[0]) +
+      2 * (point[1] >= center[1]) + 4 * (point[2] >= center[2]);
+    if (!node->_children[childIdx]) {
+      Bounds bounds(node->_bounds.min(), center);
+      for (size_t j = 0; j < 3; ++j)
+        if (childIdx & (1 << j)) {
+          bounds.min()[j] = center[j];
+          bounds.max()[j] = node->_bounds.max()[j];
+        }
+      node->_children[childIdx].reset(createNode(bounds));
+    }
+    node = node->_children[childIdx].get();
+  }
+}
+
+template <typename T>
+void PointOctree<T>::clear() {
+  _root.reset();
+  _resolution = _initialResolution;
+  _numPoints = 0;
+  _numNodes = 0;
+}
+
+template <typename T>
+typename PointOctree<T>::Node* PointOctree<T>::createNode(const Bounds&
+    bounds) {
+  Node* node = new Node();
+  node->_bounds = bounds;
+  ++_numNodes;
+  return node;
+}
+
+template <typename T>
+void PointOctree<T>::grow(const Point& point) {
+  while (!_root->_bounds.contains(point)) {
+    const Bounds& bounds = _root->_bounds;
+    const Point size = bounds.sizes();
+    Bounds grownBounds(bounds.min(), bounds.max());
+    size_t childIdx = 0;
+    for (size_t j = 0; j < 3; ++j)
+      if (point[j] < bounds.min()[j]) {
+        grownBounds.min()[j] -= size[j];
+        childIdx |= 1 << j;
+      }
+      else
+        grownBounds.max()[j] += size[j];
+    Node* root = createNode(grownBounds);
+    root->_children[childIdx].swap(_root);
+    _root.reset(root);
+  }
+}
+
+template <typename T>
+void PointOctree<T>::coarsen() {
+  _resolution *= 2;
+  if (_root)
+    prune(*_root, _resolution * gridSize);
+}
+
+template <typename T>
+void PointOctree<T>::prune(Node& node, T minSize) {
+  for (size_t i = 0; i < 8; ++i)
+    if (node._children[i]) {
+      if (node._children[i]->_bounds.sizes()[0] < T(0.75) * minSize) {
+        release(*node._children[i]);
+        node._children[i].reset();
+      }
+      else
+        prune(*node._children[i], minSize);
+    }
+}
+
+template <typename T>
+void PointOctree<T>::release(const Node& node) {
+  _numPoints -= node._points.getNumPoints();
+  --_numNodes;
+  for (size_t i = 0; i < 8; ++i)
+    if (node._children[i])
+      release(*node._children[i]);
+}
@@ -0,0 +1,109 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file VoxelGrid.h
+    \brief This file defines a hashed voxel grid.
+  */
+
+#ifndef VOXELGRID_H
+#define VOXELGRID_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <unordered_map>
+
+#include <eigen3/Eigen/Core>
+
+/** The VoxelGrid class associates values with the voxels of an unbounded
+    regular grid. Voxels are addressed by a 64-bit key packing the quantized
+    coordinates of a point, 21 bits per axis, and stored in a hash map, such
+    that memory follows the occupied space only. Coordinates further than
+    2^20 voxels from the origin wrap around.
+    \brief Hashed voxel grid.
+  */
+template <typename V, typename T = float> class VoxelGrid {
+public:
+  /** \name Types definitions
+    @{
+    */
+  /// Point type
+  typedef Eigen::Matrix<T, 3, 1> Point;
+  /// Voxel key type
+  typedef uint64_t Key;
+  /// Voxel container type
+  typedef std::unordered_map<Key, V> Container;
+  /** @}
+    */
+
+  /** \name Constructors/destructor
+    @{
+    */
+  /// Constructs the grid with a voxel size
+  VoxelGrid(T voxelSize = T(0.1));
+  /// Destructor
+  ~VoxelGrid();
+  /** @}
+    */
+
+  /** \name Accessors
+    @{
+    */
+  /// Sets the voxel size, removing all voxels
+  void setVoxelSize(T voxelSize);
+  /// Returns the voxel size
+  T getVoxelSize() const;
+  /// Returns the number of occupied voxels
+  size_t getNumVoxels() const;
+  /// Returns the key of the voxel containing a point
+  Key getKey(const Point& point) const;
+  /// Returns the value of a voxel, null if the voxel is empty
+  V* getVoxel(Key key);
+  /// Returns the value of a voxel, null if the voxel is empty
+  const V* getVoxel(Key key) const;
+  /** @}
+    */
+
+  /** \name Methods
+    @{
+    */
+  /// Sets the value of a voxel and returns it
+  V& setVoxel(Key key, const V& value);
+  /// Empties a voxel
+  void removeVoxel(Key key);
+  /// Empties all voxels
+  void clear();
+  /** @}
+    */
+
+protected:
+  /** \name Protected members
+    @{
+    */
+  /// Voxel size
+  T _voxelSize;
+  /// Occupied voxels
+  Container _voxels;
+  /** @}
+    */
+
+};
+
+#include "utils/VoxelGrid.tpp"
+
+#endif // VOXELGRID_H
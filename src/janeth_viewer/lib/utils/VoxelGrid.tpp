@@ -0,0 +1,93 @@
+/******************************************************************************
+ * Copyright (C) 2013 by Jerome Maye                                          *
+ * jerome.maye@gmail.com                                                      *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include <cmath>
+
+/******************************************************************************/
+/* Constructors and Destructor                                                */
+/******************************************************************************/
+
+template <typename V, typename T>
+VoxelGrid<V, T>::VoxelGrid(T voxelSize) :
+    _voxelSize(voxelSize) {
+}
+
+template <typename V, typename T>
+VoxelGrid<V, T>::~VoxelGrid() {
+}
+
+/******************************************************************************/
+/* Accessors                                                                  */
+/******************************************************************************/
+
+template <typename V, typename T>
+void VoxelGrid<V, T>::setVoxelSize(T voxelSize) {
+  _voxelSize = voxelSize;
+  clear();
+}
+
+template <typename V, typename T>
+T VoxelGrid<V, T>::getVoxelSize() const {
+  return _voxelSize;
+}
+
+template <typename V, typename T>
+size_t VoxelGrid<V, T>::getNumVoxels() const {
+  return _voxels.size();
+}
+
+template <typename V, typename T>
+typename VoxelGrid<V, T>::Key VoxelGrid<V, T>::getKey(const Point& point)
+    const {
+  Key key = 0;
+  for (size_t i = 0; i < 3; ++i)
+    key = (key << 21) | ((Key)(int64_t)std::floor(point[i] / _voxelSize) &
+      0x1fffff);
+  return key;
+}
+
+template <typename V, typename T>
+V* VoxelGrid<V, T>::getVoxel(Key key) {
+  typename Container::iterator it = _voxels.find(key);
+  return it != _voxels.end() ? &it->second : 0;
+}
+
+template <typename V, typename T>
+const V* VoxelGrid<V, T>::getVoxel(Key key) const {
+  typename Container::const_iterator it = _voxels.find(key);
+  return it != _voxels.end() ? &it->second : 0;
+}
+
+/******************************************************************************/
+/* Methods                                                                    */
+/******************************************************************************/
+
+template <typename V, typename T>
+V& VoxelGrid<V, T>::setVoxel(Key key, const V& value) {
+  return _voxels[key] = value;
+}
+
+template <typename V, typename T>
+void VoxelGrid<V, T>::removeVoxel(Key key) {
+  _voxels.erase(key);
+}
+
+template <typename V, typename T>
+void VoxelGrid<V, T>::clear() {
+  _voxels.clear();
+}